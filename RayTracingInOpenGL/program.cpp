@@ -1,5 +1,13 @@
 // Ray Tracing In OpenGL.
 
+#include <cmath>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <string>
+#include <cstring>
 #include <iostream>
 
 #include <glad/glad.h>
@@ -10,9 +18,23 @@
 #include "sources/graphics/ibo.h"
 #include "sources/graphics/shader.h"
 #include "sources/graphics/texture.h"
+#include "sources/graphics/texture_array.h"
+#include "sources/graphics/texture_loader.h"
+#include "sources/graphics/latency_timer.h"
 
 #include "sources/utils/camera.h"
 #include "sources/utils/debug.h"
+#include "sources/utils/frame_capture.h"
+#include "sources/utils/thread_pool.h"
+#include "sources/utils/triple_buffer.h"
+
+#include "sources/tracing/scene.h"
+#include "sources/tracing/scene_file.h"
+#include "sources/tracing/bvh.h"
+#include "sources/tracing/renderer.h"
+#include "sources/tracing/gpu_renderer.h"
+#include "sources/tracing/cpu_renderer.h"
+#include "sources/tracing/convergence_benchmark.h"
 
 // Global variables.
 int WINDOW_WIDTH = 1280;
@@ -21,6 +43,9 @@ int WINDOW_HEIGHT = 720;
 int OUTPUT_TEXTURE_WIDTH = 1280;
 int OUTPUT_TEXTURE_HEIGHT = 720;
 
+int MATERIAL_TEXTURE_SIZE = 1024; // Every material texture is resampled to this size (power of two).
+const char* MATERIAL_TEXTURE_FILEPATHS[] = { "textures/sphere.ppm", "textures/plane.ppm" }; // Indexed by "texture_layer".
+
 float FIELD_OF_VIEW = 45.0f;
 float WINDOW_ASPECT_RATIO = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
 float CAMERA_TRANSLATION_SPEED = 7.5f;
@@ -30,24 +55,119 @@ float CURSOR_POS_Y = (float)WINDOW_HEIGHT / 2.0f;
 
 bool CURSOR_ATTACHED = false;
 
+float SIMULATION_RATE = 240.0f; // Input and camera updates per second, whatever the frame rate.
+
 float DELTA_TIME = 0.0f;
-float LAST_FRAME = 0.0f;
+float LAST_STEP = 0.0f;
 
 float CURR_TIME = 0.0f;
 float LAST_TIME = 0.0f;
 
 unsigned int FRAMES_COUNTER = 0;
 
+const char* CAPTURE_FILEPATH = "capture.y4m"; // Use "|command" to pipe the stream into an external encoder.
+int CAPTURE_FRAME_RATE = 60;
+int CAPTURE_RING_SIZE = 4;
+
+const char* SCENE_FILEPATH = NULL; // Set by the "--scene <path>" argument, the default scene is used when NULL or unreadable.
+int SCENE_EXTRA_SPHERES = 0; // Small spheres added to the default scene, to stress the BVH.
+
+float SPHERE_MOVE_HEIGHT = 1.0f; // The first sphere goes up and down by this much, to check that the cache follows edits.
+bool SPHERE_MOVED = false;
+
+MappedFile* SCENE_MAPPING = NULL; // Kept until the GPU buffers are created from it, only the CPU backend keeps a copy.
+SceneFileSections SCENE_SECTIONS = {};
+
+int SORT_PROBE_FRAMES = 120; // Frames measured with and without ray sorting when probing its benefit.
+int SORT_PROBE_WARMUP_FRAMES = 10; // Skipped at the start of each half, GPU timings lag a few frames behind.
+int SORT_PROBE_FRAME = -1;
+bool SORT_PROBE_PREVIOUS_SETTING = false;
+
+float SORT_PROBE_TIMES[2][Renderer::STAGE_COUNT];
+
+bool BENCHMARK = false; // Set by the "--benchmark" argument, runs the convergence benchmark instead of the application.
+unsigned int BENCHMARK_REFERENCE_SAMPLES = 1024;
+const char* BENCHMARK_REFERENCE_FILEPATH = "benchmark_reference.bin";
+const char* BENCHMARK_RESULTS_FILEPATH = "benchmark"; // ".json" and ".csv" are appended.
+std::vector<float> BENCHMARK_TIME_BUDGETS = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f }; // In seconds, increasing.
+unsigned int BENCHMARK_CHECK_SAMPLES = 16; // Samples rendered by both backends to compare their images.
+float BENCHMARK_CHECK_TOLERANCE = 1e-3f; // Largest RMSE allowed between the GPU and CPU images.
+
 ShaderProgram* renderScreenQuadSP;
-ShaderProgram* renderOutputTexSP;
 
 Texture* outputTex;
+TextureArray* materialTexs;
+
+ThreadPool* threadPool;
+TextureLoader* textureLoader;
+
+FrameCapture* frameCapture = NULL;
+
+Renderer* renderers[2]; // GPU and CPU backends.
+Renderer* renderer;
 
 VAO* quadVAO;
 VBO* quadVBO;
 
+LatencyTimer* latencyTimer;
+
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
+// GLFW only delivers events to the main thread, which therefore runs the input and camera updates at a fixed rate
+// ("runSimulation()") while a second thread owns the OpenGL context and renders ("runRendering()"). The simulation
+// thread publishes a snapshot of everything a frame depends on after each step, and the render thread picks up the
+// newest one at the start of each frame, so neither ever waits on the other.
+//
+enum Action { TOGGLE_RAY_SORT, SWITCH_BACKEND, PROBE_RAY_SORT, CYCLE_SAMPLER, TOGGLE_CAPTURE, CYCLE_INDIRECT, ACTION_COUNT };
+
+// The scene is edited by the simulation thread, which never changes a published version but publishes a new one, so
+// the render thread keeps drawing the version it holds until it has updated the renderers.
+struct SceneVersion
+{
+	Scene scene;
+	Bvh* bvh;
+
+	unsigned int sequence; // Of the first state that carries this version.
+	glm::vec3 changedMin, changedMax; // Region that differs from the newest version rendered before it.
+
+	~SceneVersion() { delete bvh; }
+};
+
+struct FrameState
+{
+	Camera camera;
+	float fieldOfView;
+
+	std::shared_ptr<const SceneVersion> sceneVersion;
+
+	int framebufferWidth, framebufferHeight;
+
+	unsigned int actions[ACTION_COUNT]; // Requests since startup, the render thread runs the ones it has not run yet.
+
+	unsigned int sequence;
+	double time; // Simulation step the state was published at (see "glfwGetTime()").
+	double inputTime; // Oldest input not rendered yet (see "glfwGetTime()"), negative if none.
+};
+
+std::shared_ptr<const SceneVersion> editedScene; // Simulation thread side.
+std::shared_ptr<const SceneVersion> renderedScene; // Render thread side, the renderers point into it.
+
+TripleBuffer<FrameState>* frameStates;
+TripleBuffer<std::string>* windowTitles; // Published the other way round, only the main thread may change the window.
+
+unsigned int ACTION_REQUESTS[ACTION_COUNT] = {}; // Simulation thread side.
+unsigned int ACTION_RUNS[ACTION_COUNT] = {}; // Render thread side.
+
+unsigned int FRAME_SEQUENCE = 0;
+std::atomic<unsigned int> RENDERED_SEQUENCE(0); // Sequence of the latest state the render thread drew.
+
+double INPUT_TIME = -1.0; // First input since the latest step, negative if none.
+double UNRENDERED_INPUT_TIME = -1.0; // Carried by every published state until one of them is rendered.
+unsigned int UNRENDERED_INPUT_SEQUENCE = 0;
+
+std::atomic<bool> RENDERING(true);
+int EXIT_CODE = 0;
+
 // GLFW window callbacks.
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void keyboardCallback(GLFWwindow* window, int key, int scanCode, int action, int mods);
@@ -55,6 +175,7 @@ void cursorPositionCallback(GLFWwindow* window, double xPos, double yPos);
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset);
 
 void processInput(GLFWwindow* window);
+void recordInput();
 
 void getApplicationLimitations()
 {
@@ -103,7 +224,6 @@ void setupApplication()
 	};
 
 	renderScreenQuadSP = new ShaderProgram("sources/shaders/render_screen_quad_vs.glsl", "sources/shaders/render_screen_quad_fs.glsl");
-	renderOutputTexSP = new ShaderProgram("sources/shaders/render_output_tex_rt_cs.glsl");
 
 	renderScreenQuadSP->bind();
 	renderScreenQuadSP->setUniform1i("u_texture", 0);
@@ -111,7 +231,42 @@ void setupApplication()
 	outputTex = new Texture(OUTPUT_TEXTURE_WIDTH, OUTPUT_TEXTURE_HEIGHT, GL_RGBA32F, GL_RGBA, GL_FLOAT);
 
 	outputTex->bind(0);
-	outputTex->bindImage(0, GL_READ_WRITE, GL_RGBA32F);
+
+	int materialTexLayers = sizeof(MATERIAL_TEXTURE_FILEPATHS) / sizeof(MATERIAL_TEXTURE_FILEPATHS[0]);
+
+	if (materialTexLayers > MAX_TEXTURE_LAYERS)
+	{
+		std::cout << "[ERROR] TEXTURE LOADER: " << materialTexLayers << " material textures, only the first " << MAX_TEXTURE_LAYERS << " are loaded." << std::endl;
+
+		materialTexLayers = MAX_TEXTURE_LAYERS;
+	}
+
+	int materialTexLevels = (int)std::log2(MATERIAL_TEXTURE_SIZE) + 1;
+
+	materialTexs = new TextureArray(MATERIAL_TEXTURE_SIZE, MATERIAL_TEXTURE_SIZE, materialTexLayers, materialTexLevels, GL_RGBA8);
+	materialTexs->bind(1);
+
+	threadPool = new ThreadPool();
+	textureLoader = new TextureLoader(materialTexs, threadPool);
+
+	for (int i = 0; i < materialTexLayers; i++)
+	{
+		textureLoader->load(MATERIAL_TEXTURE_FILEPATHS[i], i);
+	}
+
+	// The read slot still holds the initial state, whose scene is the loaded one even if it was edited meanwhile.
+	renderedScene = frameStates->getReadBuffer().sceneVersion;
+
+	const Scene& scene = renderedScene->scene;
+
+	renderers[0] = new GpuRenderer(scene, renderedScene->bvh, OUTPUT_TEXTURE_WIDTH, OUTPUT_TEXTURE_HEIGHT, textureLoader, SCENE_MAPPING ? &SCENE_SECTIONS : NULL);
+	renderers[1] = new CpuRenderer(scene, renderedScene->bvh, OUTPUT_TEXTURE_WIDTH, OUTPUT_TEXTURE_HEIGHT, textureLoader, threadPool);
+
+	delete SCENE_MAPPING;
+
+	SCENE_MAPPING = NULL;
+
+	renderer = renderers[0];
 
 	quadVAO = new VAO();
 	quadVBO = new VBO(quadVertices, sizeof(quadVertices));
@@ -126,19 +281,11 @@ void setupApplication()
 	quadVBO->unbind();
 }
 
-void render(float currentFrame)
+void render(FrameState& state)
 {
-	renderOutputTexSP->bind();
-
-	renderOutputTexSP->setUniform3f("u_view_position", camera.getPosition());
-	renderOutputTexSP->setUniformMatrix4fv("u_view_matrix", camera.getViewMatrix());
-	renderOutputTexSP->setUniform1f("u_fov", glm::radians(FIELD_OF_VIEW));
-
-	glDispatchCompute((unsigned int)OUTPUT_TEXTURE_WIDTH, (unsigned int)OUTPUT_TEXTURE_HEIGHT, 1);
-
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT); // Make sure writing to image has finished before read.
+	textureLoader->update();
 
-	renderOutputTexSP->unbind();
+	renderer->render(state.camera, state.fieldOfView, outputTex);
 
 	glClearColor(0.25f, 0.5f, 0.25f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -150,9 +297,211 @@ void render(float currentFrame)
 
 	quadVAO->unbind();
 	renderScreenQuadSP->unbind();
+
+	if (frameCapture)
+	{
+		frameCapture->capture(outputTex, state.time);
+	}
+}
+
+bool runConvergenceBenchmark(FrameState& state)
+{
+	// The reference must not be rendered with partially streamed textures.
+	while (!textureLoader->isIdle())
+	{
+		textureLoader->update();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	ConvergenceBenchmark benchmark(renderedScene->scene, OUTPUT_TEXTURE_WIDTH, OUTPUT_TEXTURE_HEIGHT, outputTex);
+
+	if (!benchmark.prepareReference(renderers[1], state.camera, state.fieldOfView, BENCHMARK_REFERENCE_SAMPLES, BENCHMARK_REFERENCE_FILEPATH)) return false;
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (int sampler = 0; sampler < Sampler::TYPE_COUNT; sampler++)
+		{
+			benchmark.addConfiguration(renderers[i], (Sampler::Type)sampler, false, Renderer::INDIRECT_CACHED);
+		}
+
+		benchmark.addConfiguration(renderers[i], Sampler::SOBOL, true, Renderer::INDIRECT_CACHED);
+		benchmark.addConfiguration(renderers[i], Sampler::SOBOL, false, Renderer::INDIRECT_PATHS);
+	}
+
+	benchmark.run(state.camera, state.fieldOfView, BENCHMARK_TIME_BUDGETS);
+
+	bool backendsMatch = benchmark.checkBackends(renderers[0], renderers[1], state.camera, state.fieldOfView, BENCHMARK_CHECK_SAMPLES, BENCHMARK_CHECK_TOLERANCE);
+
+	return benchmark.writeResults(BENCHMARK_RESULTS_FILEPATH) && backendsMatch;
+}
+
+void loadScene()
+{
+	SceneVersion* version = new SceneVersion();
+
+	version->bvh = NULL;
+	version->sequence = 0;
+	version->changedMin = version->changedMax = glm::vec3(0.0f);
+
+	SCENE_MAPPING = SCENE_FILEPATH ? new MappedFile(SCENE_FILEPATH) : NULL;
+
+	if (!SCENE_MAPPING || !loadSceneFile(*SCENE_MAPPING, SCENE_FILEPATH, version->scene, version->bvh, &SCENE_SECTIONS))
+	{
+		delete SCENE_MAPPING;
+
+		SCENE_MAPPING = NULL;
+		version->scene = createDefaultScene(SCENE_EXTRA_SPHERES);
+	}
+
+	if (!version->bvh) version->bvh = new Bvh(version->scene);
+
+	editedScene.reset(version);
+}
+
+void moveSphere()
+{
+	if (editedScene->scene.spheres.empty()) return;
+
+	SceneVersion* version = new SceneVersion();
+
+	version->scene = editedScene->scene;
+
+	Sphere& sphere = version->scene.spheres[0];
+	glm::vec3 offset(0.0f, SPHERE_MOVED ? -SPHERE_MOVE_HEIGHT : SPHERE_MOVE_HEIGHT, 0.0f);
+
+	// Both the old and the new place of the sphere are lit differently now.
+	version->changedMin = glm::min(sphere.center, sphere.center + offset) - sphere.radius;
+	version->changedMax = glm::max(sphere.center, sphere.center + offset) + sphere.radius;
+	version->sequence = FRAME_SEQUENCE + 1;
+
+	// States the render thread skips are lost, so a version it never drew passes its changes on to the next one.
+	if (RENDERED_SEQUENCE.load() < editedScene->sequence)
+	{
+		version->changedMin = glm::min(version->changedMin, editedScene->changedMin);
+		version->changedMax = glm::max(version->changedMax, editedScene->changedMax);
+	}
+
+	sphere.center += offset;
+	SPHERE_MOVED = !SPHERE_MOVED;
+
+	version->bvh = new Bvh(version->scene);
+
+	editedScene.reset(version);
+}
+
+void probeRaySorting()
+{
+	if (SORT_PROBE_FRAME < 0) return;
+
+	int half = SORT_PROBE_FRAME / SORT_PROBE_FRAMES;
+
+	if (SORT_PROBE_FRAME % SORT_PROBE_FRAMES >= SORT_PROBE_WARMUP_FRAMES)
+	{
+		for (int i = 0; i < Renderer::STAGE_COUNT; i++)
+		{
+			SORT_PROBE_TIMES[half][i] += renderer->getStageMilliseconds((Renderer::Stage)i);
+		}
+	}
+
+	SORT_PROBE_FRAME += 1;
+
+	if (SORT_PROBE_FRAME == SORT_PROBE_FRAMES) // First half traces unsorted rays, second half sorted ones.
+	{
+		renderer->setSortRays(true);
+	}
+	else if (SORT_PROBE_FRAME == 2 * SORT_PROBE_FRAMES)
+	{
+		float measuredFrames = (float)(SORT_PROBE_FRAMES - SORT_PROBE_WARMUP_FRAMES);
+		float times[2][Renderer::STAGE_COUNT];
+
+		for (int i = 0; i < Renderer::STAGE_COUNT; i++)
+		{
+			times[0][i] = SORT_PROBE_TIMES[0][i] / measuredFrames;
+			times[1][i] = SORT_PROBE_TIMES[1][i] / measuredFrames;
+		}
+
+		// Only the sort and shadow stages change, the others are shown to tell measurement noise apart.
+		float saved = times[0][Renderer::SHADOW] - (times[1][Renderer::SHADOW] + times[1][Renderer::SORT]);
+
+		std::cout << "[INFO] RAY SORT (" << renderer->getName() << "), unsorted -> sorted: primary " << times[0][Renderer::PRIMARY] << " -> "
+			<< times[1][Renderer::PRIMARY] << " ms | sort " << times[0][Renderer::SORT] << " -> " << times[1][Renderer::SORT] << " ms | shadow "
+			<< times[0][Renderer::SHADOW] << " -> " << times[1][Renderer::SHADOW] << " ms | indirect " << times[0][Renderer::INDIRECT] << " -> "
+			<< times[1][Renderer::INDIRECT] << " ms -> " << (saved > 0.0f ? "pays off, saves " : "does not pay off, costs ") << std::abs(saved)
+			<< " ms per frame." << std::endl;
+
+		renderer->setSortRays(SORT_PROBE_PREVIOUS_SETTING);
+
+		SORT_PROBE_FRAME = -1;
+	}
 }
 
-void showFramesPerSecond(GLFWwindow* window)
+void runAction(Action action)
+{
+	if (action == TOGGLE_RAY_SORT && SORT_PROBE_FRAME < 0) // Toggle the shadow ray sort stage.
+	{
+		renderer->setSortRays(!renderer->getSortRays());
+	}
+
+	if (action == SWITCH_BACKEND && SORT_PROBE_FRAME < 0) // Switch between the GPU and CPU backends.
+	{
+		bool sortRays = renderer->getSortRays();
+		Sampler::Type sampler = renderer->getSampler();
+		Renderer::IndirectMode indirectMode = renderer->getIndirectMode();
+
+		renderer = renderer == renderers[0] ? renderers[1] : renderers[0];
+		renderer->setSortRays(sortRays);
+		renderer->setSampler(sampler);
+		renderer->setIndirectMode(indirectMode);
+	}
+
+	if (action == PROBE_RAY_SORT && SORT_PROBE_FRAME < 0) // Measure whether sorting pays for itself.
+	{
+		SORT_PROBE_PREVIOUS_SETTING = renderer->getSortRays();
+		SORT_PROBE_FRAME = 0;
+
+		std::fill(&SORT_PROBE_TIMES[0][0], &SORT_PROBE_TIMES[0][0] + 2 * Renderer::STAGE_COUNT, 0.0f);
+
+		renderer->setSortRays(false);
+	}
+
+	if (action == CYCLE_SAMPLER) // Cycle through the sample generators.
+	{
+		renderer->setSampler((Sampler::Type)((renderer->getSampler() + 1) % Sampler::TYPE_COUNT));
+
+		std::cout << "[INFO] SAMPLER: " << Sampler::getTypeName(renderer->getSampler()) << "." << std::endl;
+	}
+
+	if (action == CYCLE_INDIRECT) // Cycle through the indirect lighting modes.
+	{
+		renderer->setIndirectMode((Renderer::IndirectMode)((renderer->getIndirectMode() + 1) % Renderer::INDIRECT_MODE_COUNT));
+
+		std::cout << "[INFO] INDIRECT LIGHTING: " << Renderer::getIndirectModeName(renderer->getIndirectMode()) << "." << std::endl;
+	}
+
+	if (action == TOGGLE_CAPTURE) // Start/stop recording the output texture.
+	{
+		if (frameCapture)
+		{
+			delete frameCapture;
+
+			frameCapture = NULL;
+		}
+		else
+		{
+			frameCapture = new FrameCapture(CAPTURE_FILEPATH, OUTPUT_TEXTURE_WIDTH, OUTPUT_TEXTURE_HEIGHT, CAPTURE_FRAME_RATE, CAPTURE_RING_SIZE);
+
+			if (!frameCapture->isRecording())
+			{
+				delete frameCapture;
+
+				frameCapture = NULL;
+			}
+		}
+	}
+}
+
+void showFramesPerSecond()
 {
 	CURR_TIME = (float)glfwGetTime();
 	FRAMES_COUNTER += 1;
@@ -163,56 +512,114 @@ void showFramesPerSecond(GLFWwindow* window)
 	{
 		std::string FPS = std::to_string((int)((1.0f / delta) * FRAMES_COUNTER));
 		std::string ms = std::to_string((delta / FRAMES_COUNTER) * 1000.0f);
-		std::string newTitle = "RT OpenGL - [" + FPS + " FPS / " + ms + " ms]";
+		std::string newTitle = "RT OpenGL - [" + FPS + " FPS / " + ms + " ms] [" + renderer->getName() + (renderer->getSortRays() ? ", sorted rays]" : "]");
+
+		newTitle += " [" + std::string(Sampler::getTypeName(renderer->getSampler())) + ", " + std::to_string(renderer->getSampleCount()) + " spp]";
+		newTitle += " [" + std::string(Renderer::getIndirectModeName(renderer->getIndirectMode())) + " "
+			+ std::to_string(renderer->getStageMilliseconds(Renderer::INDIRECT)) + " ms]";
+
+		if (frameCapture)
+		{
+			std::string captured = std::to_string(frameCapture->getCapturedFrames());
+			std::string dropped = std::to_string(frameCapture->getDroppedFrames());
+
+			newTitle += " [REC " + captured + " frames / " + dropped + " dropped]";
+		}
 
-		glfwSetWindowTitle(window, newTitle.c_str());
+		newTitle += " [input latency " + std::to_string(latencyTimer->getMilliseconds()) + " ms]";
+
+		windowTitles->getWriteBuffer() = newTitle;
+		windowTitles->publish();
 
 		LAST_TIME = CURR_TIME;
 		FRAMES_COUNTER = 0;
 	}
 }
 
-int main()
+void publishFrameState(double time)
 {
-	if (!glfwInit())
+	FRAME_SEQUENCE += 1;
+
+	// States the render thread skips are lost, so the oldest input stays in every state until one of them is drawn.
+	if (UNRENDERED_INPUT_TIME >= 0.0 && RENDERED_SEQUENCE.load() >= UNRENDERED_INPUT_SEQUENCE)
 	{
-		std::cout << "Failed to initialize GLFW!" << std::endl;
+		UNRENDERED_INPUT_TIME = -1.0;
+	}
 
-		return -1;
+	if (INPUT_TIME >= 0.0 && UNRENDERED_INPUT_TIME < 0.0)
+	{
+		UNRENDERED_INPUT_TIME = INPUT_TIME;
+		UNRENDERED_INPUT_SEQUENCE = FRAME_SEQUENCE;
 	}
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+	INPUT_TIME = -1.0;
 
-	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "RT OpenGL", NULL, NULL);
+	FrameState& state = frameStates->getWriteBuffer();
 
-	if (!window)
+	state.camera = camera;
+	state.fieldOfView = FIELD_OF_VIEW;
+	state.sceneVersion = editedScene;
+	state.framebufferWidth = WINDOW_WIDTH;
+	state.framebufferHeight = WINDOW_HEIGHT;
+	state.sequence = FRAME_SEQUENCE;
+	state.time = time;
+	state.inputTime = UNRENDERED_INPUT_TIME;
+
+	std::copy(ACTION_REQUESTS, ACTION_REQUESTS + ACTION_COUNT, state.actions);
+
+	frameStates->publish();
+}
+
+void runSimulation(GLFWwindow* window)
+{
+	double step = 1.0 / SIMULATION_RATE;
+	double nextStep = glfwGetTime();
+
+	LAST_STEP = (float)nextStep;
+
+	while (!glfwWindowShouldClose(window) && RENDERING)
 	{
-		std::cout << "Failed to create GLFW context/window!" << std::endl;
-		glfwTerminate();
+		double currentTime = glfwGetTime();
 
-		return -1;
-	}
+		if (currentTime < nextStep)
+		{
+			glfwWaitEventsTimeout(nextStep - currentTime); // Events that arrive meanwhile are handled right away.
 
-	glfwMakeContextCurrent(window);
+			continue;
+		}
 
-	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
-	glfwSetKeyCallback(window, keyboardCallback);
-	glfwSetCursorPosCallback(window, cursorPositionCallback);
-	glfwSetScrollCallback(window, scrollCallback);
+		nextStep = std::max(nextStep + step, currentTime); // Steps missed after a stall are dropped, not caught up.
 
-	glfwSwapInterval(0);
+		DELTA_TIME = (float)currentTime - LAST_STEP;
+		LAST_STEP = (float)currentTime;
 
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		glfwPollEvents();
+		processInput(window);
+
+		publishFrameState(currentTime);
+
+		if (windowTitles->update())
+		{
+			glfwSetWindowTitle(window, windowTitles->getReadBuffer().c_str());
+		}
+	}
+}
+
+void runRendering(GLFWwindow* window)
+{
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
 		std::cout << "Failed to initialize GLAD!" << std::endl;
-		glfwTerminate();
 
-		return -1;
+		EXIT_CODE = -1;
+		RENDERING = false;
+
+		glfwPostEmptyEvent();
+
+		return;
 	}
 
 	glEnable(GL_DEPTH_TEST);
@@ -234,26 +641,140 @@ int main()
 	getApplicationLimitations();
 	setupApplication();
 
-	while (!glfwWindowShouldClose(window))
+	latencyTimer = new LatencyTimer();
+
+	int viewportWidth = 0; // Set from the first frame state.
+	int viewportHeight = 0;
+	double renderedInputTime = -1.0;
+
+	if (BENCHMARK)
 	{
-		float currentFrame = (float)glfwGetTime();
+		frameStates->update();
 
-		DELTA_TIME = currentFrame - LAST_FRAME;
-		LAST_FRAME = currentFrame;
+		EXIT_CODE = runConvergenceBenchmark(frameStates->getReadBuffer()) ? 0 : 1;
+		RENDERING = false;
 
-		processInput(window);
-		showFramesPerSecond(window);
+		glfwPostEmptyEvent();
+	}
+
+	while (RENDERING)
+	{
+		frameStates->update();
+
+		FrameState& state = frameStates->getReadBuffer();
+
+		for (int i = 0; i < ACTION_COUNT; i++)
+		{
+			for (; ACTION_RUNS[i] != state.actions[i]; ACTION_RUNS[i]++)
+			{
+				runAction((Action)i);
+			}
+		}
 
-		render(currentFrame);
+		if (state.sceneVersion != renderedScene) // Only the region that changed loses its cached irradiance.
+		{
+			const SceneVersion& version = *state.sceneVersion;
+
+			renderers[0]->updateScene(version.scene, version.bvh, version.changedMin, version.changedMax);
+			renderers[1]->updateScene(version.scene, version.bvh, version.changedMin, version.changedMax);
+
+			renderedScene = state.sceneVersion; // The previous version may only be freed now.
+		}
+
+		if (state.framebufferWidth != viewportWidth || state.framebufferHeight != viewportHeight)
+		{
+			viewportWidth = state.framebufferWidth;
+			viewportHeight = state.framebufferHeight;
+
+			glViewport(0, 0, viewportWidth, viewportHeight);
+		}
+
+		showFramesPerSecond();
+
+		render(state);
+		probeRaySorting();
 
 		glfwSwapBuffers(window);
-		glfwPollEvents();
+
+		// Only the first frame drawn from an input measures its latency.
+		latencyTimer->submit(state.inputTime != renderedInputTime ? state.inputTime : -1.0, glfwGetTime());
+
+		renderedInputTime = state.inputTime;
+		RENDERED_SEQUENCE = state.sequence;
+	}
+
+	delete latencyTimer;
+	delete frameCapture;
+	delete renderers[0];
+	delete renderers[1];
+	delete textureLoader;
+	delete threadPool;
+
+	renderedScene.reset();
+
+	glfwMakeContextCurrent(NULL);
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--benchmark") == 0) BENCHMARK = true;
+		if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) SCENE_FILEPATH = argv[++i]; // Written by "SceneConverter".
 	}
 
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW!" << std::endl;
+
+		return -1;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+
+	GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "RT OpenGL", NULL, NULL);
+
+	if (!window)
+	{
+		std::cout << "Failed to create GLFW context/window!" << std::endl;
+		glfwTerminate();
+
+		return -1;
+	}
+
+	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+	glfwSetKeyCallback(window, keyboardCallback);
+	glfwSetCursorPosCallback(window, cursorPositionCallback);
+	glfwSetScrollCallback(window, scrollCallback);
+
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	loadScene();
+
+	FrameState initialState = { camera, FIELD_OF_VIEW, editedScene, WINDOW_WIDTH, WINDOW_HEIGHT, {}, 0, glfwGetTime(), -1.0 };
+
+	frameStates = new TripleBuffer<FrameState>(initialState);
+	windowTitles = new TripleBuffer<std::string>("RT OpenGL");
+
+	std::thread renderThread(runRendering, window);
+
+	runSimulation(window);
+
+	RENDERING = false;
+	renderThread.join();
+
+	delete frameStates;
+	delete windowTitles;
+
+	editedScene.reset();
+
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
-	return 0;
+	return EXIT_CODE;
 }
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
@@ -262,16 +783,36 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 	WINDOW_HEIGHT = height;
 
 	WINDOW_ASPECT_RATIO = (float)width / (float)height;
-
-	glViewport(0, 0, width, height);
 }
 
 void keyboardCallback(GLFWwindow* window, int key, int scanCode, int action, int mods)
 {
-	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) // Window should close.
+	if (action != GLFW_PRESS) return;
+
+	if (key == GLFW_KEY_ESCAPE) // Window should close.
 	{
 		glfwSetWindowShouldClose(window, true);
 	}
+
+	if (key == GLFW_KEY_F11) // Edit the scene, the irradiance cache is only cleared around the sphere.
+	{
+		moveSphere();
+	}
+
+	// Everything else acts on the renderers, so it is forwarded to the render thread, see "runAction()".
+	if (key == GLFW_KEY_F5) ACTION_REQUESTS[TOGGLE_RAY_SORT] += 1;
+
+	if (key == GLFW_KEY_F6) ACTION_REQUESTS[SWITCH_BACKEND] += 1;
+
+	if (key == GLFW_KEY_F7) ACTION_REQUESTS[PROBE_RAY_SORT] += 1;
+
+	if (key == GLFW_KEY_F8) ACTION_REQUESTS[CYCLE_SAMPLER] += 1;
+
+	if (key == GLFW_KEY_F9) ACTION_REQUESTS[TOGGLE_CAPTURE] += 1;
+
+	if (key == GLFW_KEY_F10) ACTION_REQUESTS[CYCLE_INDIRECT] += 1;
+
+	recordInput();
 }
 
 void cursorPositionCallback(GLFWwindow* window, double xPos, double yPos)
@@ -297,23 +838,36 @@ void cursorPositionCallback(GLFWwindow* window, double xPos, double yPos)
 	yOffset *= CAMERA_SENSITIVITY;
 
 	camera.processRotation(xOffset, yOffset);
+
+	recordInput();
 }
 
 void scrollCallback(GLFWwindow* window, double xOffset, double yOffset)
 {
 	FIELD_OF_VIEW = FIELD_OF_VIEW - (float)yOffset;
 	FIELD_OF_VIEW = std::min(std::max(FIELD_OF_VIEW, 1.0f), 45.0f);
+
+	recordInput();
 }
 
 void processInput(GLFWwindow* window)
 {
 	float realCameraSpeed = CAMERA_TRANSLATION_SPEED * DELTA_TIME;
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) camera.processTranslation(Camera::Direction::FORWARD, realCameraSpeed);
+	int keys[] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_A };
+	Camera::Direction directions[] = { Camera::Direction::FORWARD, Camera::Direction::BACKWARD, Camera::Direction::RIGHT, Camera::Direction::LEFT };
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (glfwGetKey(window, keys[i]) != GLFW_PRESS) continue;
 
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) camera.processTranslation(Camera::Direction::BACKWARD, realCameraSpeed);
+		camera.processTranslation(directions[i], realCameraSpeed);
 
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) camera.processTranslation(Camera::Direction::RIGHT, realCameraSpeed);
+		recordInput();
+	}
+}
 
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) camera.processTranslation(Camera::Direction::LEFT, realCameraSpeed);
+void recordInput()
+{
+	if (INPUT_TIME < 0.0) INPUT_TIME = glfwGetTime();
 }
@@ -0,0 +1,47 @@
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer(int ringSize)
+	: IDs(), ringSize(ringSize < 8 ? ringSize : 8), queryIndex(0), issuedQueries(0), milliseconds(0.0f)
+{
+	glGenQueries(this->ringSize, IDs);
+}
+
+GpuTimer::~GpuTimer()
+{
+	glDeleteQueries(ringSize, IDs);
+}
+
+void GpuTimer::begin()
+{
+	// Collect the oldest result before its query object gets reused.
+	if (issuedQueries >= ringSize)
+	{
+		int available = 0;
+
+		glGetQueryObjectiv(IDs[queryIndex], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available)
+		{
+			GLuint64 nanoseconds = 0;
+
+			glGetQueryObjectui64v(IDs[queryIndex], GL_QUERY_RESULT, &nanoseconds);
+
+			milliseconds = (float)nanoseconds / 1000000.0f;
+		}
+	}
+
+	glBeginQuery(GL_TIME_ELAPSED, IDs[queryIndex]);
+}
+
+void GpuTimer::end()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+
+	queryIndex = (queryIndex + 1) % ringSize;
+	issuedQueries += 1;
+}
+
+float GpuTimer::getMilliseconds()
+{
+	return milliseconds;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Measures the GPU time spent between begin() and end() without stalling: results are read back a few frames later,
+// once the oldest query of the ring is available.
+//
+class GpuTimer
+{
+public:
+	GpuTimer(int ringSize = 4);
+	~GpuTimer();
+
+	void begin();
+	void end();
+
+	float getMilliseconds(); // Latest available measurement.
+
+private:
+	unsigned int IDs[8];
+
+	int ringSize, queryIndex, issuedQueries;
+	float milliseconds;
+};
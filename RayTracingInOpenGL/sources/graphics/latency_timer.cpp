@@ -0,0 +1,62 @@
+#include "latency_timer.h"
+
+LatencyTimer::LatencyTimer(int ringSize)
+	: IDs(), inputTimes(), clockOffsets(), ringSize(ringSize < 8 ? ringSize : 8), queryIndex(0), milliseconds(0.0f)
+{
+	glGenQueries(this->ringSize, IDs);
+
+	for (int i = 0; i < this->ringSize; i++)
+	{
+		inputTimes[i] = -1.0;
+	}
+}
+
+LatencyTimer::~LatencyTimer()
+{
+	glDeleteQueries(ringSize, IDs);
+}
+
+void LatencyTimer::submit(double inputTime, double currentTime)
+{
+	// Collect every finished result first, the oldest slot is then free unless the GPU lags a whole ring behind.
+	for (int i = 1; i <= ringSize; i++)
+	{
+		collect((queryIndex + i) % ringSize);
+	}
+
+	if (inputTime < 0.0 || inputTimes[queryIndex] >= 0.0) return;
+
+	GLint64 gpuTime = 0;
+
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	glQueryCounter(IDs[queryIndex], GL_TIMESTAMP);
+
+	inputTimes[queryIndex] = inputTime;
+	clockOffsets[queryIndex] = currentTime - (double)gpuTime * 1e-9;
+
+	queryIndex = (queryIndex + 1) % ringSize;
+}
+
+float LatencyTimer::getMilliseconds()
+{
+	return milliseconds;
+}
+
+void LatencyTimer::collect(int index)
+{
+	if (inputTimes[index] < 0.0) return;
+
+	int available = 0;
+
+	glGetQueryObjectiv(IDs[index], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (!available) return;
+
+	GLuint64 gpuTime = 0;
+
+	glGetQueryObjectui64v(IDs[index], GL_QUERY_RESULT, &gpuTime);
+
+	milliseconds = (float)(((double)gpuTime * 1e-9 + clockOffsets[index] - inputTimes[index]) * 1000.0);
+
+	inputTimes[index] = -1.0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Measures input-to-photon latency without stalling: the time from an input event to the moment the GPU finished the
+// first frame that reflects it. A timestamp query is issued after the frame's last command and read back a few
+// frames later, like "GpuTimer" does. The GPU timestamp is converted to the clock of the input events through the
+// offset between both clocks, sampled when the query is issued.
+//
+// The time the compositor and the display take to show the finished frame is not included.
+//
+class LatencyTimer
+{
+public:
+	LatencyTimer(int ringSize = 4);
+	~LatencyTimer();
+
+	// Call after the frame's last command. "inputTime" is negative when the frame reflects no new input, and
+	// "currentTime" is the current time in the same clock.
+	void submit(double inputTime, double currentTime);
+
+	float getMilliseconds(); // Latest available measurement.
+
+private:
+	unsigned int IDs[8];
+	double inputTimes[8], clockOffsets[8];
+
+	int ringSize, queryIndex;
+	float milliseconds;
+
+	void collect(int index);
+};
@@ -75,6 +75,34 @@ void ShaderProgram::setUniform1i(const char* uniformName, int data)
 	}
 }
 
+void ShaderProgram::setUniform1ui(const char* uniformName, unsigned int data)
+{
+	int uniformLocation = glGetUniformLocation(ID, uniformName);
+
+	if (uniformLocation > -1)
+	{
+		glUniform1ui(uniformLocation, data);
+	}
+	else
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Failed to get location of uniform \"" << uniformName << "\"." << std::endl;
+	}
+}
+
+void ShaderProgram::setUniform2i(const char* uniformName, int x, int y)
+{
+	int uniformLocation = glGetUniformLocation(ID, uniformName);
+
+	if (uniformLocation > -1)
+	{
+		glUniform2i(uniformLocation, x, y);
+	}
+	else
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Failed to get location of uniform \"" << uniformName << "\"." << std::endl;
+	}
+}
+
 void ShaderProgram::setUniform1f(const char* uniformName, float data)
 {
 	int uniformLocation = glGetUniformLocation(ID, uniformName);
@@ -89,6 +117,20 @@ void ShaderProgram::setUniform1f(const char* uniformName, float data)
 	}
 }
 
+void ShaderProgram::setUniform1fv(const char* uniformName, int count, const float* data)
+{
+	int uniformLocation = glGetUniformLocation(ID, uniformName);
+
+	if (uniformLocation > -1)
+	{
+		glUniform1fv(uniformLocation, count, data);
+	}
+	else
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Failed to get location of uniform \"" << uniformName << "\"." << std::endl;
+	}
+}
+
 void ShaderProgram::setUniform3f(const char* uniformName, const glm::vec3& data)
 {
 	int uniformLocation = glGetUniformLocation(ID, uniformName);
@@ -122,9 +164,7 @@ unsigned int ShaderProgram::createShader(const char* sFilepath, int shaderType)
 	int success;
 	char infoLog[512];
 
-	std::ifstream fileStream(sFilepath);
-	std::stringstream stringStream; stringStream << fileStream.rdbuf();
-	std::string shaderSource = stringStream.str();
+	std::string shaderSource = readShaderSource(sFilepath);
 
 	const char* shaderCode = shaderSource.c_str();
 	unsigned int shaderID = glCreateShader(shaderType);
@@ -146,3 +186,35 @@ unsigned int ShaderProgram::createShader(const char* sFilepath, int shaderType)
 
 	return shaderID;
 }
+
+std::string ShaderProgram::readShaderSource(const std::string& sFilepath)
+{
+	std::ifstream fileStream(sFilepath);
+	std::stringstream stringStream;
+	std::string line;
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SHADER PROGRAM: Failed to open \"" << sFilepath << "\"." << std::endl;
+	}
+
+	// Lines like '#include "file.glsl"' are replaced by the content of that file, relative to the including one.
+	while (std::getline(fileStream, line))
+	{
+		if (line.compare(0, 9, "#include ") == 0)
+		{
+			size_t begin = line.find('"') + 1;
+			size_t end = line.find('"', begin);
+
+			std::string directory = sFilepath.substr(0, sFilepath.find_last_of("/\\") + 1);
+
+			stringStream << readShaderSource(directory + line.substr(begin, end - begin));
+		}
+		else
+		{
+			stringStream << line << "\n";
+		}
+	}
+
+	return stringStream.str();
+}
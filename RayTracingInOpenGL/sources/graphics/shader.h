@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -19,7 +20,10 @@ public:
 	void unbind();
 
 	void setUniform1i(const char* uniformName, int data);
+	void setUniform1ui(const char* uniformName, unsigned int data);
+	void setUniform2i(const char* uniformName, int x, int y);
 	void setUniform1f(const char* uniformName, float data);
+	void setUniform1fv(const char* uniformName, int count, const float* data);
 	void setUniform3f(const char* uniformName, const glm::vec3& data);
 	void setUniformMatrix4fv(const char* uniformName, const glm::mat4& data);
 
@@ -27,4 +31,6 @@ private:
 	unsigned int ID;
 
 	unsigned int createShader(const char* sFilepath, int shaderType);
+
+	std::string readShaderSource(const std::string& sFilepath);
 };
@@ -0,0 +1,40 @@
+#include "ssbo.h"
+
+SSBO::SSBO(const void* data, long long size, int usage)
+	: ID(), size(size)
+{
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+SSBO::~SSBO()
+{
+	glDeleteBuffers(1, &ID);
+}
+
+void SSBO::bind(unsigned int index)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, ID);
+}
+
+void SSBO::bindIndirect()
+{
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ID);
+}
+
+void SSBO::setData(const void* data, long long size, long long offset)
+{
+	glNamedBufferSubData(ID, offset, size, data);
+}
+
+void SSBO::clear()
+{
+	glClearNamedBufferData(ID, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+}
+
+long long SSBO::getSize()
+{
+	return size;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+class SSBO
+{
+public:
+	SSBO(const void* data, long long size, int usage = GL_DYNAMIC_DRAW);
+	~SSBO();
+
+	void bind(unsigned int index);
+	void bindIndirect();
+
+	void setData(const void* data, long long size, long long offset = 0);
+	void clear();
+
+	long long getSize();
+
+private:
+	unsigned int ID;
+
+	long long size;
+};
@@ -41,6 +41,16 @@ void Texture::bindImage(int unit, int access, int format)
 	}
 }
 
+void Texture::getImage(int format, int type, int size, void* pixels)
+{
+	glGetTextureImage(ID, 0, format, type, size, pixels);
+}
+
+void Texture::setImage(int width, int height, int format, int type, const void* pixels)
+{
+	glTextureSubImage2D(ID, 0, 0, 0, width, height, format, type, pixels);
+}
+
 void Texture::unbind()
 {
 	glBindTexture(GL_TEXTURE_2D, 0);
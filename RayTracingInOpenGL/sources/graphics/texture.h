@@ -11,6 +11,8 @@ public:
 
 	void bind(int unit);
 	void bindImage(int unit, int access, int format);
+	void getImage(int format, int type, int size, void* pixels);
+	void setImage(int width, int height, int format, int type, const void* pixels);
 
 	void unbind();
 
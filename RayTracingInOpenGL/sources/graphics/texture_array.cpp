@@ -0,0 +1,64 @@
+#include "texture_array.h"
+
+TextureArray::TextureArray(int width, int height, int layers, int levels, int internalFormat)
+	: ID(), width(width), height(height), layers(layers), levels(levels)
+{
+	glGenTextures(1, &ID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+
+	// Immutable storage keeps the texture complete while its levels are still being streamed in.
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height, layers);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::bind(int unit)
+{
+	if (unit >= 0 && unit <= 15)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+	}
+	else
+	{
+		std::cout << "[ERROR] TEXTURE ARRAY: Failed to bind texture array in " << unit << " unit." << std::endl;
+	}
+}
+
+void TextureArray::setLevel(int layer, int level, int format, int type, const void* pixels)
+{
+	int levelWidth = std::max(width >> level, 1);
+	int levelHeight = std::max(height >> level, 1);
+
+	glTextureSubImage3D(ID, level, 0, 0, layer, levelWidth, levelHeight, 1, format, type, pixels);
+}
+
+void TextureArray::unbind()
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+int TextureArray::getWidth()
+{
+	return width;
+}
+
+int TextureArray::getHeight()
+{
+	return height;
+}
+
+int TextureArray::getLayers()
+{
+	return layers;
+}
+
+int TextureArray::getLevels()
+{
+	return levels;
+}
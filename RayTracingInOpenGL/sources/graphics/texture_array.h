@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+class TextureArray
+{
+public:
+	TextureArray(int width, int height, int layers, int levels, int internalFormat);
+
+	void bind(int unit);
+	void setLevel(int layer, int level, int format, int type, const void* pixels);
+
+	void unbind();
+
+	int getWidth();
+	int getHeight();
+	int getLayers();
+	int getLevels();
+
+private:
+	unsigned int ID;
+
+	int width, height, layers, levels;
+};
@@ -0,0 +1,286 @@
+#include "texture_loader.h"
+
+static bool readPPM(const std::string& filepath, int& width, int& height, std::vector<unsigned char>& rgb)
+{
+	std::ifstream fileStream(filepath, std::ios::binary);
+	std::string magic;
+	int maxValue = 0;
+
+	fileStream >> magic;
+
+	if (!fileStream || magic != "P6") return false;
+
+	int* fields[3] = { &width, &height, &maxValue };
+
+	for (int i = 0; i < 3; i++)
+	{
+		fileStream >> std::ws;
+
+		while (fileStream.peek() == '#') // Skip comment lines.
+		{
+			fileStream.ignore(4096, '\n');
+			fileStream >> std::ws;
+		}
+
+		fileStream >> *fields[i];
+	}
+
+	fileStream.get(); // Single whitespace before the raster.
+
+	if (!fileStream || width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 255) return false;
+
+	rgb.resize((size_t)width * height * 3);
+	fileStream.read((char*)rgb.data(), rgb.size());
+
+	return (bool)fileStream;
+}
+
+TextureLoader::TextureLoader(TextureArray* textures, ThreadPool* threadPool, int ringSize)
+	: textures(textures), threadPool(threadPool), ID(), ringSize(ringSize), segmentSize(textures->getWidth() * textures->getHeight() * 4),
+	  segmentIndex(0), mappedPixels(NULL), segments(ringSize), layerLods(textures->getLayers(), -1.0f),
+	  residentLevels(textures->getLayers(), std::vector<std::vector<unsigned char>>(textures->getLevels())), pendingDecodes(0)
+{
+	for (Segment& segment : segments)
+	{
+		segment.fence = NULL;
+	}
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ID);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)segmentSize * ringSize, NULL, flags);
+
+	mappedPixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)segmentSize * ringSize, flags);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!mappedPixels)
+	{
+		std::cout << "[ERROR] TEXTURE LOADER: Failed to map the staging buffer." << std::endl;
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		// Decoding jobs still hold a pointer to this loader.
+		std::unique_lock<std::mutex> lock(decodedMutex);
+
+		decodedCondition.wait(lock, [this] { return pendingDecodes == 0; });
+	}
+
+	for (Segment& segment : segments)
+	{
+		if (segment.fence) glDeleteSync(segment.fence);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ID);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	glDeleteBuffers(1, &ID);
+}
+
+void TextureLoader::load(const char* filepath, int layer)
+{
+	if (layer < 0 || layer >= textures->getLayers())
+	{
+		std::cout << "[ERROR] TEXTURE LOADER: Layer " << layer << " is out of range." << std::endl;
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(decodedMutex);
+
+		pendingDecodes += 1;
+	}
+
+	std::string path(filepath);
+
+	threadPool->enqueue([this, path, layer] { decode(path, layer); });
+}
+
+void TextureLoader::update()
+{
+	{
+		// Never wait on the decoding threads, whatever they finished is picked up in a later frame instead.
+		std::unique_lock<std::mutex> lock(decodedMutex, std::try_to_lock);
+
+		if (lock.owns_lock() && !decodedLevels.empty())
+		{
+			for (Level& level : decodedLevels)
+			{
+				uploads.push_back(std::move(level));
+			}
+
+			decodedLevels.clear();
+
+			// Coarse levels of every layer go first, so that all textures show up before any of them sharpens.
+			std::stable_sort(uploads.begin(), uploads.end(), [](const Level& a, const Level& b) { return a.level > b.level; });
+		}
+	}
+
+	if (uploads.empty() || !mappedPixels) return;
+
+	Segment& segment = segments[segmentIndex];
+
+	if (segment.fence)
+	{
+		GLenum result = glClientWaitSync(segment.fence, 0, 0);
+
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) return; // Staging memory still in use.
+
+		glDeleteSync(segment.fence);
+
+		segment.fence = NULL;
+	}
+
+	size_t segmentOffset = (size_t)segmentIndex * segmentSize;
+	size_t usedSize = 0;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	while (!uploads.empty() && usedSize + uploads.front().pixels.size() <= (size_t)segmentSize)
+	{
+		Level& level = uploads.front();
+
+		memcpy(mappedPixels + segmentOffset + usedSize, level.pixels.data(), level.pixels.size());
+
+		textures->setLevel(level.layer, level.level, GL_RGBA, GL_UNSIGNED_BYTE, (void*)(segmentOffset + usedSize));
+
+		layerLods[level.layer] = (float)level.level;
+		usedSize += level.pixels.size();
+
+		residentLevels[level.layer][level.level] = std::move(level.pixels);
+
+		uploads.pop_front();
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	segment.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	segmentIndex = (segmentIndex + 1) % ringSize;
+}
+
+bool TextureLoader::isIdle()
+{
+	std::lock_guard<std::mutex> lock(decodedMutex);
+
+	return pendingDecodes == 0 && decodedLevels.empty() && (uploads.empty() || !mappedPixels);
+}
+
+const std::vector<float>& TextureLoader::getLayerLods()
+{
+	return layerLods;
+}
+
+const unsigned char* TextureLoader::getLevelPixels(int layer, int level, int& width, int& height)
+{
+	width = std::max(textures->getWidth() >> level, 1);
+	height = std::max(textures->getHeight() >> level, 1);
+
+	if (residentLevels[layer][level].empty()) return NULL;
+
+	return residentLevels[layer][level].data();
+}
+
+void TextureLoader::decode(const std::string& filepath, int layer)
+{
+	int sourceWidth = 0, sourceHeight = 0;
+	std::vector<unsigned char> rgb;
+	std::vector<Level> levels;
+
+	if (readPPM(filepath, sourceWidth, sourceHeight, rgb))
+	{
+		int width = textures->getWidth();
+		int height = textures->getHeight();
+
+		levels.resize(textures->getLevels());
+
+		// Bilinear resampling of the source image to the size of the array.
+		std::vector<unsigned char>& base = levels[0].pixels;
+		base.resize((size_t)width * height * 4);
+
+		for (int y = 0; y < height; y++)
+		{
+			float sy = std::max((y + 0.5f) * sourceHeight / height - 0.5f, 0.0f);
+			int y0 = std::min((int)sy, sourceHeight - 1), y1 = std::min(y0 + 1, sourceHeight - 1);
+			float fy = sy - y0;
+
+			for (int x = 0; x < width; x++)
+			{
+				float sx = std::max((x + 0.5f) * sourceWidth / width - 0.5f, 0.0f);
+				int x0 = std::min((int)sx, sourceWidth - 1), x1 = std::min(x0 + 1, sourceWidth - 1);
+				float fx = sx - x0;
+
+				// The image is stored top row first while texture coordinates grow upwards.
+				const unsigned char* r0 = rgb.data() + (size_t)(sourceHeight - 1 - y0) * sourceWidth * 3;
+				const unsigned char* r1 = rgb.data() + (size_t)(sourceHeight - 1 - y1) * sourceWidth * 3;
+
+				for (int c = 0; c < 3; c++)
+				{
+					float top = r0[x0 * 3 + c] * (1.0f - fx) + r0[x1 * 3 + c] * fx;
+					float bottom = r1[x0 * 3 + c] * (1.0f - fx) + r1[x1 * 3 + c] * fx;
+
+					base[((size_t)y * width + x) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+				}
+
+				base[((size_t)y * width + x) * 4 + 3] = 255;
+			}
+		}
+
+		// Box filtered mip chain.
+		for (int i = 1; i < (int)levels.size(); i++)
+		{
+			int srcWidth = std::max(width >> (i - 1), 1), srcHeight = std::max(height >> (i - 1), 1);
+			int dstWidth = std::max(width >> i, 1), dstHeight = std::max(height >> i, 1);
+
+			const std::vector<unsigned char>& src = levels[i - 1].pixels;
+			std::vector<unsigned char>& dst = levels[i].pixels;
+
+			dst.resize((size_t)dstWidth * dstHeight * 4);
+
+			for (int y = 0; y < dstHeight; y++)
+			{
+				int sy0 = std::min(y * 2, srcHeight - 1), sy1 = std::min(y * 2 + 1, srcHeight - 1);
+
+				for (int x = 0; x < dstWidth; x++)
+				{
+					int sx0 = std::min(x * 2, srcWidth - 1), sx1 = std::min(x * 2 + 1, srcWidth - 1);
+
+					for (int c = 0; c < 4; c++)
+					{
+						int sum = src[((size_t)sy0 * srcWidth + sx0) * 4 + c] + src[((size_t)sy0 * srcWidth + sx1) * 4 + c]
+							+ src[((size_t)sy1 * srcWidth + sx0) * 4 + c] + src[((size_t)sy1 * srcWidth + sx1) * 4 + c];
+
+						dst[((size_t)y * dstWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)levels.size(); i++)
+		{
+			levels[i].layer = layer;
+			levels[i].level = i;
+		}
+	}
+	else
+	{
+		std::cout << "[ERROR] TEXTURE LOADER: Failed to decode \"" << filepath << "\"." << std::endl;
+	}
+
+	std::lock_guard<std::mutex> lock(decodedMutex);
+
+	for (int i = (int)levels.size() - 1; i >= 0; i--)
+	{
+		decodedLevels.push_back(std::move(levels[i]));
+	}
+
+	pendingDecodes -= 1;
+
+	decodedCondition.notify_all();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <deque>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "texture_array.h"
+#include "../utils/thread_pool.h"
+
+// Streams image files into the layers of a mipmapped RGBA8 texture array.
+//
+// Decoding, resampling to the array size and mip generation run on the thread pool. The render thread calls update()
+// once per frame, which copies at most one staging segment worth of finished levels into a persistently mapped pixel
+// unpack buffer and uploads them from there, coarsest levels first. A layer is therefore usable as soon as its
+// smallest level lands, and getLayerLods() tells the shader which is the finest level resident in each layer.
+//
+// Only binary PPM (P6) files are decoded.
+//
+class TextureLoader
+{
+public:
+	TextureLoader(TextureArray* textures, ThreadPool* threadPool, int ringSize = 3);
+	~TextureLoader();
+
+	void load(const char* filepath, int layer);
+	void update();
+
+	bool isIdle(); // Every requested level is resident, or failed to decode.
+
+	const std::vector<float>& getLayerLods(); // A negative LOD means nothing is resident in that layer yet.
+
+	// CPU copy of a resident level (RGBA8, bottom row first), for the CPU backend. Only valid on the render thread.
+	const unsigned char* getLevelPixels(int layer, int level, int& width, int& height);
+
+private:
+	struct Level
+	{
+		int layer, level;
+
+		std::vector<unsigned char> pixels;
+	};
+
+	struct Segment
+	{
+		GLsync fence;
+	};
+
+	TextureArray* textures;
+	ThreadPool* threadPool;
+
+	unsigned int ID;
+
+	int ringSize, segmentSize, segmentIndex;
+	unsigned char* mappedPixels;
+
+	std::vector<Segment> segments;
+	std::vector<float> layerLods;
+	std::vector<std::vector<std::vector<unsigned char>>> residentLevels; // Indexed by layer and level.
+
+	std::deque<Level> uploads;
+	std::vector<Level> decodedLevels;
+	std::mutex decodedMutex;
+	std::condition_variable decodedCondition;
+
+	int pendingDecodes;
+
+	void decode(const std::string& filepath, int layer);
+};
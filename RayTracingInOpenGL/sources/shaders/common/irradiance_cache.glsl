@@ -0,0 +1,151 @@
+// World-space cache of diffuse indirect irradiance, a hash grid whose cells are mirrored by "IrradianceCache" in
+// "sources/tracing/irradiance_cache.cpp", which describes how they are filled, blended and evicted.
+// The layouts must match the ones allocated in "sources/tracing/gpu_renderer.cpp".
+
+#ifndef IRRADIANCE_CACHE_GLSL
+#define IRRADIANCE_CACHE_GLSL
+
+#include "sampler.glsl"
+
+#define CACHE_CELLS_BINDING 16
+#define CACHE_ACCUMULATORS_BINDING 17
+
+#define CACHE_CAPACITY 262144u // Power of two.
+#define CACHE_PROBE_COUNT 8u
+#define CACHE_CELL_SCALE (1.0 / 64.0) // Cell size relative to the distance to the camera, rounded down to a power of two.
+#define CACHE_FIXED_POINT_SCALE 4096.0
+#define CACHE_MAX_SAMPLE_VALUE 16.0
+#define CACHE_TRAINING_STRIDE 16u // About one pixel in this many traces a path to fill in the cache each frame.
+
+struct CacheCell
+{
+	vec3 center;
+
+	uint key; // Checksum of the cell, 0 when the slot is free.
+
+	vec3 irradiance;
+
+	uint sample_count; // Samples blended into "irradiance", 0 until the first update after the cell was claimed.
+
+	float half_size;
+
+	uint last_frame; // Last frame the cell was looked up or filled in.
+	uint padding0, padding1;
+};
+
+layout (std430, binding = CACHE_CELLS_BINDING) buffer CacheCells { CacheCell cache_cells[]; };
+
+// Fixed-point sums of the samples added to each cell since the last update, then their count.
+layout (std430, binding = CACHE_ACCUMULATORS_BINDING) buffer CacheAccumulators { uvec4 cache_accumulators[]; };
+
+uniform uint u_cache_frame;
+
+int cache_cell_level(vec3 point, vec3 view_position)
+{
+	return clamp(int(floor(log2(max(length(point - view_position) * CACHE_CELL_SCALE, 1e-6)))), -16, 15);
+}
+
+// Hash of the cell containing "point", at the level chosen from its distance to "view_position" and for the side
+// of the major axis "normal" points to, so that both faces of thin objects do not share cells.
+uint cache_cell_hash(vec3 point, vec3 normal, vec3 view_position, out vec3 center, out float half_size)
+{
+	int level = cache_cell_level(point, view_position);
+	float size = exp2(float(level));
+
+	ivec3 cell = ivec3(floor(point / size));
+
+	vec3 a = abs(normal);
+	uint axis = a.x >= a.y && a.x >= a.z ? 0u : (a.y >= a.z ? 1u : 2u);
+	uint side = normal[axis] < 0.0 ? 1u : 0u;
+
+	center = (vec3(cell) + 0.5) * size;
+	half_size = 0.5 * size;
+
+	uint hash = sampler_hash(uint(cell.x));
+
+	hash = sampler_hash(sampler_hash_combine(hash, uint(cell.y)));
+	hash = sampler_hash(sampler_hash_combine(hash, uint(cell.z)));
+
+	return sampler_hash(sampler_hash_combine(hash, uint(level + 16) | ((axis * 2u + side) << 5)));
+}
+
+// Slot of the cell, 0xFFFFFFFF if it is not in the cache. Claims a free slot for it when "insert" is set, unless the
+// probing sequence is full.
+uint cache_find(vec3 point, vec3 normal, vec3 view_position, bool insert)
+{
+	vec3 center;
+	float half_size;
+
+	uint hash = cache_cell_hash(point, normal, view_position, center, half_size);
+	uint checksum = sampler_hash(hash + 1u) | 1u;
+
+	for (uint i = 0u; i < CACHE_PROBE_COUNT; i++)
+	{
+		uint slot = (hash + i) & (CACHE_CAPACITY - 1u);
+		uint key = cache_cells[slot].key;
+
+		if (key == 0u)
+		{
+			if (!insert) return 0xFFFFFFFFu; // Cells are claimed in probing order, none goes past a free slot.
+
+			key = atomicCompSwap(cache_cells[slot].key, 0u, checksum);
+
+			if (key == 0u)
+			{
+				cache_cells[slot].center = center;
+				cache_cells[slot].half_size = half_size;
+				cache_cells[slot].last_frame = u_cache_frame;
+
+				return slot;
+			}
+		}
+
+		if (key == checksum) return slot;
+	}
+
+	return 0xFFFFFFFFu;
+}
+
+// Cached irradiance at "point", false if its cell has not been filled in yet.
+bool cache_query(vec3 point, vec3 normal, vec3 view_position, out vec3 irradiance)
+{
+	irradiance = vec3(0.0);
+
+	uint slot = cache_find(point, normal, view_position, false);
+
+	if (slot == 0xFFFFFFFFu || cache_cells[slot].sample_count == 0u) return false;
+
+	irradiance = cache_cells[slot].irradiance;
+	cache_cells[slot].last_frame = u_cache_frame;
+
+	return true;
+}
+
+// Whether the pixel traces a path to fill in the cache this frame, spread differently every frame.
+bool cache_is_training_pixel(uint pixel)
+{
+	return sampler_hash(pixel ^ sampler_hash(u_cache_frame)) % CACHE_TRAINING_STRIDE == 0u;
+}
+
+// Offset of the lookup point of the pixel over the cell, in [0, 1)^2. Plain white noise is enough to blend the
+// cells, and much cheaper than the sampler.
+vec2 cache_jitter(uint pixel)
+{
+	uint hash = sampler_hash(sampler_hash_combine(sampler_hash(pixel), u_sample_index));
+
+	return vec2(hash & 0xFFFFu, hash >> 16) * (1.0 / 65536.0);
+}
+
+void cache_add_sample(uint slot, vec3 irradiance)
+{
+	uvec3 value = uvec3(clamp(irradiance, 0.0, CACHE_MAX_SAMPLE_VALUE) * CACHE_FIXED_POINT_SCALE + 0.5);
+
+	atomicAdd(cache_accumulators[slot].x, value.x);
+	atomicAdd(cache_accumulators[slot].y, value.y);
+	atomicAdd(cache_accumulators[slot].z, value.z);
+	atomicAdd(cache_accumulators[slot].w, 1u);
+
+	cache_cells[slot].last_frame = u_cache_frame;
+}
+
+#endif
@@ -0,0 +1,96 @@
+// Sample generator of the tracing kernels, mirrored bit for bit by "Sampler" in "sources/tracing/sampler.cpp", which
+// describes the sampler types.
+
+#ifndef SAMPLER_GLSL
+#define SAMPLER_GLSL
+
+#define SAMPLER_RANDOM 0
+#define SAMPLER_SOBOL 1
+#define SAMPLER_BLUE_NOISE 2
+
+#define BLUE_NOISE_BINDING 13
+#define BLUE_NOISE_SIZE 64u
+
+// Ranks of a tileable BLUE_NOISE_SIZE * BLUE_NOISE_SIZE blue noise mask.
+layout (std430, binding = BLUE_NOISE_BINDING) readonly buffer BlueNoise { uint blue_noise[]; };
+
+uniform int u_sampler = SAMPLER_SOBOL;
+uniform uint u_sample_index; // Samples already accumulated in every pixel.
+
+uint sampler_hash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+
+	return x;
+}
+
+uint sampler_hash_combine(uint seed, uint value)
+{
+	return seed ^ (value + 0x9E3779B9u + (seed << 6) + (seed >> 2));
+}
+
+uint sampler_nested_uniform_scramble(uint x, uint seed)
+{
+	x = bitfieldReverse(x);
+
+	x += seed;
+	x ^= x * 0x6C50B47Cu;
+	x ^= x * 0xB82F1E52u;
+	x ^= x * 0xC7AFE638u;
+	x ^= x * 0x8D22F6E6u;
+
+	return bitfieldReverse(x);
+}
+
+uint sampler_sobol(uint index, uint dimension)
+{
+	if (dimension == 0u) return bitfieldReverse(index);
+
+	uint result = 0u;
+
+	for (uint direction = 0x80000000u; index != 0u; index >>= 1, direction ^= direction >> 1)
+	{
+		if ((index & 1u) != 0u) result ^= direction;
+	}
+
+	return result;
+}
+
+uint sampler_sobol_owen(uint seed, uint sample_index, uint dimension)
+{
+	uint pair_seed = sampler_hash(sampler_hash_combine(seed, dimension >> 1));
+	uint index = sampler_nested_uniform_scramble(sample_index, pair_seed);
+
+	return sampler_nested_uniform_scramble(sampler_sobol(index, dimension & 1u), sampler_hash(sampler_hash_combine(pair_seed, (dimension & 1u) + 1u)));
+}
+
+// Dimension "dimension" of the current sample of a pixel, in [0, 1).
+float sampler_get(uvec2 pixel, uint dimension)
+{
+	uint pixel_seed = sampler_hash((pixel.x & 0xFFFFu) | (pixel.y << 16));
+	uint value;
+
+	if (u_sampler == SAMPLER_RANDOM)
+	{
+		value = sampler_hash(sampler_hash_combine(sampler_hash_combine(pixel_seed, u_sample_index), dimension));
+	}
+	else if (u_sampler == SAMPLER_SOBOL)
+	{
+		value = sampler_sobol_owen(pixel_seed, u_sample_index, dimension);
+	}
+	else
+	{
+		uvec2 coords = (pixel + dimension * uvec2(23u, 41u)) % BLUE_NOISE_SIZE;
+		uint shift = blue_noise[coords.y * BLUE_NOISE_SIZE + coords.x] * (0xFFFFFFFFu / (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE));
+
+		value = sampler_sobol_owen(0u, u_sample_index, dimension) + shift;
+	}
+
+	return float(value >> 8) * (1.0 / 16777216.0);
+}
+
+#endif
@@ -0,0 +1,430 @@
+// Scene description and intersection routines shared by the tracing kernels.
+// The layouts must match the structs declared in "sources/tracing/scene.h".
+
+#ifndef SCENE_GLSL
+#define SCENE_GLSL
+
+#define PI 3.14159265359
+
+#define MAX_TEXTURE_LAYERS 16 // Must match "sources/tracing/scene.h".
+
+#define LIGHTS_BINDING 0
+#define MATERIALS_BINDING 1
+#define SPHERES_BINDING 2
+#define PLANES_BINDING 3
+#define BVH_NODES_BINDING 10
+#define BVH_PRIMITIVES_BINDING 11
+#define TRIANGLES_BINDING 12
+
+#define BVH_WIDTH 8
+#define BVH_STACK_SIZE 32 // One entry per level of the wide tree, which "Bvh" keeps within this depth.
+
+// Primitive references, see "sources/tracing/bvh.h".
+#define PRIMITIVE_TYPE_SHIFT 30
+#define PRIMITIVE_INDEX_MASK 0x3FFFFFFFu
+#define PRIMITIVE_SPHERE 0u
+#define PRIMITIVE_PLANE 1u
+#define PRIMITIVE_TRIANGLE 2u
+
+struct Light
+{
+	vec3 position;
+	float intensity;
+	vec3 color;
+	float radius; // Spherical light casting soft shadows, a point light when 0.
+};
+
+struct Material
+{
+	vec3 diffuse_color; // Also used while the texture is not resident yet.
+
+	int texture_layer; // Negative when the material is not textured.
+};
+
+struct Sphere
+{
+	vec3 center;
+
+	float radius;
+
+	uint material;
+};
+
+struct Plane
+{
+	vec3 normal;
+
+	float y_position; // The plane equation is "y = y_position".
+	float x_size;
+	float z_size;
+
+	uint material;
+};
+
+struct Triangle
+{
+	vec3 vertex0;
+
+	uint material;
+
+	vec3 vertex1;
+	vec3 vertex2;
+};
+
+// 8-wide BVH node with child bounds quantized relative to the node, see "WideBvhNode" in "sources/tracing/bvh.h".
+struct WideBvhNode
+{
+	vec3 origin;
+
+	uint exponents_and_mask; // Signed 8-bit exponent of each axis, then the mask of interior children.
+	uint child_base;
+	uint primitive_base;
+	uint meta[2]; // One byte per slot.
+	uint quantized_min[6]; // One byte per slot, two words per axis.
+	uint quantized_max[6];
+};
+
+struct Hit
+{
+	vec3 point;
+	vec3 normal;
+	vec2 uv;
+
+	uint material;
+
+	bool performed;
+};
+
+layout (std430, binding = LIGHTS_BINDING) readonly buffer Lights { Light lights[]; };
+layout (std430, binding = MATERIALS_BINDING) readonly buffer Materials { Material materials[]; };
+layout (std430, binding = SPHERES_BINDING) readonly buffer Spheres { Sphere spheres[]; };
+layout (std430, binding = PLANES_BINDING) readonly buffer Planes { Plane planes[]; };
+layout (std430, binding = TRIANGLES_BINDING) readonly buffer Triangles { Triangle triangles[]; };
+layout (std430, binding = BVH_NODES_BINDING) readonly buffer BvhNodes { WideBvhNode bvh_nodes[]; };
+layout (std430, binding = BVH_PRIMITIVES_BINDING) readonly buffer BvhPrimitives { uint bvh_primitives[]; };
+
+layout (binding = 1) uniform sampler2DArray u_textures;
+
+uniform int u_light_count;
+uniform int u_bvh_node_count;
+
+uniform float u_global_threshold = 1e-3;
+uniform float u_texture_lods[MAX_TEXTURE_LAYERS]; // Finest mip level resident in each layer, negative if none.
+uniform int u_texture_layer_count; // Layers set in "u_texture_lods", the others are left at 0.
+
+// Maps two uniform numbers to the unit disk with the concentric mapping of Shirley and Chiu, which keeps their
+// stratification.
+vec2 concentric_disk(vec2 u)
+{
+	vec2 offset = 2.0 * u - 1.0;
+
+	if (offset.x == 0.0 && offset.y == 0.0) return vec2(0.0);
+
+	bool horizontal = abs(offset.x) > abs(offset.y);
+
+	float radius = horizontal ? offset.x : offset.y;
+	float theta = horizontal ? (PI / 4.0) * (offset.y / offset.x) : (PI / 2.0) - (PI / 4.0) * (offset.x / offset.y);
+
+	return radius * vec2(cos(theta), sin(theta));
+}
+
+// Orthonormal basis around the unit vector "w" (Duff et al. 2017).
+void orthonormal_basis(vec3 w, out vec3 tangent, out vec3 bitangent)
+{
+	float s = w.z >= 0.0 ? 1.0 : -1.0;
+	float a = -1.0 / (s + w.z);
+	float b = w.x * w.y * a;
+
+	tangent = vec3(1.0 + s * w.x * w.x * a, s * b, -s * w.x);
+	bitangent = vec3(b, s + w.y * w.y * a, -w.y);
+}
+
+// Point of the disk of a spherical light that faces "point".
+vec3 light_sample_point(Light light, vec3 point, vec2 u)
+{
+	vec2 disk = concentric_disk(u);
+
+	vec3 tangent, bitangent;
+
+	orthonormal_basis(normalize(light.position - point), tangent, bitangent);
+
+	return light.position + light.radius * (disk.x * tangent + disk.y * bitangent);
+}
+
+// Cosine distributed direction around "normal", by projecting the disk onto the hemisphere (Malley's method).
+vec3 cosine_sample_hemisphere(vec3 normal, vec2 u)
+{
+	vec2 disk = concentric_disk(u);
+
+	vec3 tangent, bitangent;
+
+	orthonormal_basis(normal, tangent, bitangent);
+
+	return normalize(disk.x * tangent + disk.y * bitangent + sqrt(max(1.0 - dot(disk, disk), 0.0)) * normal);
+}
+
+vec3 material_albedo(uint material_index, vec2 uv)
+{
+	Material material = materials[material_index];
+
+	if (material.texture_layer < 0 || material.texture_layer >= u_texture_layer_count || u_texture_lods[material.texture_layer] < 0.0)
+	{
+		return material.diffuse_color;
+	}
+
+	return textureLod(u_textures, vec3(uv, material.texture_layer), u_texture_lods[material.texture_layer]).rgb;
+}
+
+float ray_sphere_intersect(vec3 origin, vec3 direction, Sphere sphere)
+{
+	vec3 xa = origin - sphere.center;
+	float b = dot(xa, direction);
+
+	// Distance from the center to the ray rather than "b * b - dot(xa, xa)", which cancels out for small far spheres.
+	vec3 closest_offset = xa - (direction * b);
+	float delta = (sphere.radius * sphere.radius) - dot(closest_offset, closest_offset);
+
+	if (delta < 0) return -1.0;
+
+	float s1 = -b - sqrt(delta);
+	float s2 = -b + sqrt(delta);
+
+	if (s1 > 0) return s1;
+	else if (s2 > 0) return s2;
+
+	return -1.0;
+}
+
+float ray_plane_intersect(vec3 origin, vec3 direction, Plane plane)
+{
+	if (abs(direction.y) <= u_global_threshold) return -1.0;
+
+	float plane_distance = (plane.y_position - origin.y) / direction.y;
+	vec3 point = origin + (direction * plane_distance);
+
+	if (abs(point.x) < plane.x_size && abs(point.z) < plane.z_size) return plane_distance;
+
+	return -1.0;
+}
+
+// Moller-Trumbore, double sided. The barycentric coordinates of the hit are those of vertex1 and vertex2.
+float ray_triangle_intersect(vec3 origin, vec3 direction, Triangle triangle, out vec2 barycentrics)
+{
+	vec3 edge1 = triangle.vertex1 - triangle.vertex0;
+	vec3 edge2 = triangle.vertex2 - triangle.vertex0;
+	vec3 p = cross(direction, edge2);
+
+	float determinant = dot(edge1, p);
+
+	barycentrics = vec2(0.0);
+
+	if (determinant == 0.0) return -1.0;
+
+	float inverse_determinant = 1.0 / determinant;
+
+	vec3 offset = origin - triangle.vertex0;
+	float u = dot(offset, p) * inverse_determinant;
+
+	if (u < 0.0 || u > 1.0) return -1.0;
+
+	vec3 q = cross(offset, edge1);
+	float v = dot(direction, q) * inverse_determinant;
+
+	if (v < 0.0 || u + v > 1.0) return -1.0;
+
+	barycentrics = vec2(u, v);
+
+	return dot(edge2, q) * inverse_determinant;
+}
+
+float primitive_intersect(uint primitive, vec3 origin, vec3 direction)
+{
+	uint index = primitive & PRIMITIVE_INDEX_MASK;
+	uint type = primitive >> PRIMITIVE_TYPE_SHIFT;
+
+	if (type == PRIMITIVE_SPHERE) return ray_sphere_intersect(origin, direction, spheres[index]);
+	if (type == PRIMITIVE_PLANE) return ray_plane_intersect(origin, direction, planes[index]);
+
+	vec2 barycentrics;
+
+	return ray_triangle_intersect(origin, direction, triangles[index], barycentrics);
+}
+
+vec3 bvh_inverse_direction(vec3 direction)
+{
+	// Keeps the slab distances finite, so that they never turn into NaNs against boxes flat on the ray origin.
+	vec3 tiny = mix(vec3(1e-20), vec3(-1e-20), lessThan(direction, vec3(0.0)));
+
+	return 1.0 / mix(tiny, direction, greaterThan(abs(direction), vec3(1e-20)));
+}
+
+bool bvh_intersect_bounds(vec3 origin, vec3 inverse_direction, vec3 bounds_min, vec3 bounds_max, float max_distance)
+{
+	vec3 t0 = (bounds_min - origin) * inverse_direction;
+	vec3 t1 = (bounds_max - origin) * inverse_direction;
+
+	vec3 t_near = min(t0, t1);
+	vec3 t_far = max(t0, t1);
+
+	float entry = max(max(t_near.x, t_near.y), max(t_near.z, 0.0));
+	float exit = min(min(t_far.x, t_far.y), min(t_far.z, max_distance));
+
+	return entry <= exit;
+}
+
+// Closest (or any) primitive hit closer than "max_distance", which is shortened to the hit distance.
+bool bvh_traverse(vec3 origin, vec3 direction, bool any_hit, inout float max_distance, out uint hit_primitive)
+{
+	hit_primitive = 0u;
+
+	if (u_bvh_node_count == 0) return false;
+
+	bool found = false;
+
+	vec3 inverse_direction = bvh_inverse_direction(direction);
+
+	// Visiting slot "k ^ octant" for k = 0..7 goes roughly front to back, see "Bvh::collapse()".
+	uint octant = (direction.x >= 0.0 ? 1u : 0u) | (direction.y >= 0.0 ? 2u : 0u) | (direction.z >= 0.0 ? 4u : 0u);
+
+	// Child base of a node, and above its interior mask, the hit interior children still to visit in visiting order.
+	uvec2 stack[BVH_STACK_SIZE];
+	int stack_size = 0;
+
+	uint node_index = 0u;
+	bool has_node = true;
+
+	while (true)
+	{
+		if (has_node)
+		{
+			WideBvhNode node = bvh_nodes[node_index];
+
+			int exponents_and_mask = int(node.exponents_and_mask);
+			ivec3 exponents = ivec3(bitfieldExtract(exponents_and_mask, 0, 8), bitfieldExtract(exponents_and_mask, 8, 8), bitfieldExtract(exponents_and_mask, 16, 8));
+			vec3 scale = ldexp(vec3(1.0), exponents);
+
+			uint internal_mask = node.exponents_and_mask >> 24;
+			uint hits = 0u;
+
+			for (uint k = 0u; k < BVH_WIDTH; k++)
+			{
+				uint slot = k ^ octant;
+				uint word = slot >> 2;
+				uint shift = (slot & 3u) * 8u;
+
+				uint meta = (node.meta[word] >> shift) & 0xFFu;
+				bool internal = ((internal_mask >> slot) & 1u) != 0u;
+
+				if (!internal && meta == 0u) continue;
+
+				vec3 quantized_min = vec3((uvec3(node.quantized_min[word], node.quantized_min[2u + word], node.quantized_min[4u + word]) >> shift) & 0xFFu);
+				vec3 quantized_max = vec3((uvec3(node.quantized_max[word], node.quantized_max[2u + word], node.quantized_max[4u + word]) >> shift) & 0xFFu);
+
+				if (!bvh_intersect_bounds(origin, inverse_direction, node.origin + quantized_min * scale, node.origin + quantized_max * scale, max_distance)) continue;
+
+				if (internal)
+				{
+					hits |= 1u << k;
+				}
+				else
+				{
+					uint first = node.primitive_base + (meta & 31u);
+					uint count = meta >> 5;
+
+					for (uint i = 0u; i < count; i++)
+					{
+						uint primitive = bvh_primitives[first + i];
+						float distance = primitive_intersect(primitive, origin, direction);
+
+						if (distance > 0.0 && distance < max_distance)
+						{
+							max_distance = distance;
+							hit_primitive = primitive;
+							found = true;
+
+							if (any_hit) return true;
+						}
+					}
+				}
+			}
+
+			// Trees are never deeper than the stack, the check only keeps a broken one from writing past it.
+			if (hits != 0u && stack_size < BVH_STACK_SIZE)
+			{
+				stack[stack_size++] = uvec2(node.child_base, (hits << 8) | internal_mask);
+			}
+
+			has_node = false;
+		}
+
+		if (stack_size == 0) break;
+
+		uvec2 entry = stack[stack_size - 1];
+		uint k = uint(findLSB(entry.y >> 8));
+
+		entry.y &= ~(1u << (k + 8u));
+		stack[stack_size - 1] = entry;
+
+		if ((entry.y >> 8) == 0u) stack_size--;
+
+		uint slot = k ^ octant;
+
+		node_index = entry.x + uint(bitCount(entry.y & 0xFFu & ((1u << slot) - 1u)));
+		has_node = true;
+	}
+
+	return found;
+}
+
+Hit scene_intersect(vec3 origin, vec3 direction)
+{
+	Hit hit_info;
+
+	hit_info.performed = false;
+
+	float closest_distance = 1e32;
+	uint primitive;
+
+	if (!bvh_traverse(origin, direction, false, closest_distance, primitive)) return hit_info;
+
+	uint index = primitive & PRIMITIVE_INDEX_MASK;
+	uint type = primitive >> PRIMITIVE_TYPE_SHIFT;
+
+	hit_info.point = origin + (direction * closest_distance);
+	hit_info.performed = true;
+
+	if (type == PRIMITIVE_SPHERE)
+	{
+		hit_info.normal = normalize(hit_info.point - spheres[index].center);
+		hit_info.uv = vec2(0.5 + atan(hit_info.normal.z, hit_info.normal.x) / (2.0 * PI), 0.5 + asin(hit_info.normal.y) / PI);
+		hit_info.material = spheres[index].material;
+	}
+	else if (type == PRIMITIVE_PLANE)
+	{
+		hit_info.normal = planes[index].normal;
+		hit_info.uv = hit_info.point.xz * 0.25;
+		hit_info.material = planes[index].material;
+	}
+	else
+	{
+		Triangle triangle = triangles[index];
+
+		ray_triangle_intersect(origin, direction, triangle, hit_info.uv);
+
+		// Meshes come with any winding, the normal faces the ray instead.
+		hit_info.normal = normalize(cross(triangle.vertex1 - triangle.vertex0, triangle.vertex2 - triangle.vertex0));
+		hit_info.normal = dot(hit_info.normal, direction) > 0.0 ? -hit_info.normal : hit_info.normal;
+		hit_info.material = triangle.material;
+	}
+
+	return hit_info;
+}
+
+bool scene_occluded(vec3 origin, vec3 direction, float max_distance)
+{
+	uint primitive;
+
+	return bvh_traverse(origin, direction, true, max_distance, primitive);
+}
+
+#endif
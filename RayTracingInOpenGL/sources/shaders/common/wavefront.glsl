@@ -0,0 +1,90 @@
+// Buffers passed between the wavefront kernels: the primary pass emits one shadow ray per lit surface point and light,
+// which may be reordered by the radix sort before the shadow pass traces them, the indirect pass gathers the light
+// bounced off other surfaces, and the resolve pass shades the pixels.
+// The layouts must match the ones allocated in "sources/tracing/gpu_renderer.cpp".
+
+#ifndef WAVEFRONT_GLSL
+#define WAVEFRONT_GLSL
+
+#define SURFACES_BINDING 4
+#define SHADOW_RAYS_BINDING 5
+#define SORT_PAIRS_BINDING 6
+#define SORT_PAIRS_OUT_BINDING 7
+#define SORT_HISTOGRAM_BINDING 8
+#define VISIBILITY_BINDING 9
+#define ACCUMULATION_BINDING 14
+#define INDIRECT_BINDING 15
+
+#define SORT_GROUP_SIZE 256
+
+struct Surface
+{
+	vec3 point;
+
+	uint performed;
+
+	vec3 normal;
+	vec3 albedo;
+};
+
+struct ShadowRay
+{
+	vec3 origin;
+
+	uint slot; // Pixel index * u_light_count + light index.
+
+	vec3 direction;
+
+	float max_distance;
+};
+
+layout (std430, binding = SURFACES_BINDING) buffer Surfaces { Surface surfaces[]; };
+
+// The counter is followed by the indirect dispatch arguments of the passes that run once per shadow ray.
+layout (std430, binding = SHADOW_RAYS_BINDING) buffer ShadowRays
+{
+	uint shadow_ray_count;
+	uvec3 shadow_ray_groups;
+
+	ShadowRay shadow_rays[];
+};
+
+layout (std430, binding = VISIBILITY_BINDING) buffer Visibility { uint visibility[]; };
+
+// Irradiance bounced off other surfaces onto the primary hit of every pixel.
+layout (std430, binding = INDIRECT_BINDING) buffer Indirect { vec4 indirect_irradiance[]; };
+
+// Sum of the samples of every pixel so far, see "u_sample_index".
+layout (std430, binding = ACCUMULATION_BINDING) buffer Accumulation { vec4 accumulation[]; };
+
+uniform vec3 u_scene_min;
+uniform vec3 u_scene_max;
+
+uint interleave_bits(uvec3 origin_bits, uvec2 direction_bits)
+{
+	uint key = 0u;
+
+	for (int bit = 5; bit >= 0; bit--)
+	{
+		key = (key << 5) | (((direction_bits.x >> bit) & 1u) << 4) | (((direction_bits.y >> bit) & 1u) << 3)
+			| (((origin_bits.x >> bit) & 1u) << 2) | (((origin_bits.y >> bit) & 1u) << 1) | ((origin_bits.z >> bit) & 1u);
+	}
+
+	return key;
+}
+
+// 30-bit Morton-style key interleaving 6 bits of each origin coordinate (normalized to the scene bounds) and of the
+// octahedral projection of the direction, so that rays leaving nearby points in similar directions sort together.
+// Mirrored by "rayKey()" in "sources/tracing/cpu_renderer.cpp".
+uint ray_sort_key(vec3 origin, vec3 direction)
+{
+	vec3 o = clamp((origin - u_scene_min) / max(u_scene_max - u_scene_min, vec3(1e-6)), 0.0, 1.0);
+
+	vec3 d = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+	vec2 octahedral = d.z >= 0.0 ? d.xy : (1.0 - abs(d.yx)) * vec2(d.x >= 0.0 ? 1.0 : -1.0, d.y >= 0.0 ? 1.0 : -1.0);
+	vec2 od = clamp(octahedral * 0.5 + 0.5, 0.0, 1.0);
+
+	return interleave_bits(uvec3(o * 63.0 + 0.5), uvec2(od * 63.0 + 0.5));
+}
+
+#endif
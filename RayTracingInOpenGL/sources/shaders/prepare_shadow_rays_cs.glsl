@@ -0,0 +1,11 @@
+#version 460 core
+
+#include "common/wavefront.glsl"
+
+layout (local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+
+void main()
+{
+	// Sizes the indirect dispatches of the sort and shadow passes to the number of rays actually emitted.
+	shadow_ray_groups = uvec3((shadow_ray_count + SORT_GROUP_SIZE - 1) / SORT_GROUP_SIZE, 1, 1);
+}
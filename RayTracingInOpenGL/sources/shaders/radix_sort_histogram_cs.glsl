@@ -0,0 +1,37 @@
+#version 460 core
+
+#include "common/wavefront.glsl"
+
+#define RADIX 16
+
+layout (local_size_x = SORT_GROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+layout (std430, binding = SORT_PAIRS_BINDING) readonly buffer SortPairs { uvec2 sort_pairs[]; };
+layout (std430, binding = SORT_HISTOGRAM_BINDING) writeonly buffer SortHistogram { uint sort_histogram[]; };
+
+uniform uint u_shift; // Position of the 4-bit digit sorted by this pass.
+
+shared uint local_histogram[RADIX];
+
+void main()
+{
+	uint local_index = gl_LocalInvocationIndex;
+	uint pair_index = gl_GlobalInvocationID.x;
+
+	if (local_index < RADIX) local_histogram[local_index] = 0u;
+
+	barrier();
+
+	if (pair_index < shadow_ray_count)
+	{
+		atomicAdd(local_histogram[(sort_pairs[pair_index].x >> u_shift) & (RADIX - 1u)], 1u);
+	}
+
+	barrier();
+
+	// Digit-major layout, so that an exclusive scan of the whole array yields the output offset of each digit and group.
+	if (local_index < RADIX)
+	{
+		sort_histogram[local_index * gl_NumWorkGroups.x + gl_WorkGroupID.x] = local_histogram[local_index];
+	}
+}
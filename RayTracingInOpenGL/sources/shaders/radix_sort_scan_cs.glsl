@@ -0,0 +1,52 @@
+#version 460 core
+
+#include "common/wavefront.glsl"
+
+#define RADIX 16
+#define SCAN_GROUP_SIZE 1024
+
+layout (local_size_x = SCAN_GROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+layout (std430, binding = SORT_HISTOGRAM_BINDING) buffer SortHistogram { uint sort_histogram[]; };
+
+shared uint partial_sums[SCAN_GROUP_SIZE];
+
+void main()
+{
+	// A single work group turns the histogram into exclusive prefix sums: each invocation owns a contiguous chunk.
+	uint local_index = gl_LocalInvocationIndex;
+	uint total = RADIX * shadow_ray_groups.x;
+	uint chunk = (total + SCAN_GROUP_SIZE - 1u) / SCAN_GROUP_SIZE;
+
+	uint begin = min(local_index * chunk, total);
+	uint end = min(begin + chunk, total);
+
+	uint sum = 0u;
+
+	for (uint i = begin; i < end; i++) sum += sort_histogram[i];
+
+	partial_sums[local_index] = sum;
+
+	barrier();
+
+	for (uint offset = 1u; offset < SCAN_GROUP_SIZE; offset <<= 1)
+	{
+		uint value = local_index >= offset ? partial_sums[local_index - offset] : 0u;
+
+		barrier();
+
+		partial_sums[local_index] += value;
+
+		barrier();
+	}
+
+	uint running_sum = partial_sums[local_index] - sum;
+
+	for (uint i = begin; i < end; i++)
+	{
+		uint count = sort_histogram[i];
+
+		sort_histogram[i] = running_sum;
+		running_sum += count;
+	}
+}
@@ -0,0 +1,62 @@
+#version 460 core
+
+#include "common/wavefront.glsl"
+
+#define RADIX 16
+
+layout (local_size_x = SORT_GROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+layout (std430, binding = SORT_PAIRS_BINDING) readonly buffer SortPairs { uvec2 sort_pairs[]; };
+layout (std430, binding = SORT_PAIRS_OUT_BINDING) writeonly buffer SortPairsOut { uvec2 sort_pairs_out[]; };
+layout (std430, binding = SORT_HISTOGRAM_BINDING) readonly buffer SortHistogram { uint sort_histogram[]; };
+
+uniform uint u_shift; // Position of the 4-bit digit sorted by this pass.
+
+// Per digit inclusive counts of the invocations up to each one, two 16-bit counters packed per word.
+shared uint local_counts[RADIX / 2][SORT_GROUP_SIZE];
+
+void main()
+{
+	uint local_index = gl_LocalInvocationIndex;
+	uint pair_index = gl_GlobalInvocationID.x;
+
+	bool valid = pair_index < shadow_ray_count;
+
+	uvec2 pair = valid ? sort_pairs[pair_index] : uvec2(0u);
+	uint digit = (pair.x >> u_shift) & (RADIX - 1u);
+
+	for (uint i = 0u; i < RADIX / 2u; i++)
+	{
+		local_counts[i][local_index] = valid && digit / 2u == i ? 1u << ((digit & 1u) * 16u) : 0u;
+	}
+
+	barrier();
+
+	for (uint offset = 1u; offset < SORT_GROUP_SIZE; offset <<= 1)
+	{
+		uint values[RADIX / 2];
+
+		for (uint i = 0u; i < RADIX / 2u; i++)
+		{
+			values[i] = local_index >= offset ? local_counts[i][local_index - offset] : 0u;
+		}
+
+		barrier();
+
+		for (uint i = 0u; i < RADIX / 2u; i++)
+		{
+			local_counts[i][local_index] += values[i];
+		}
+
+		barrier();
+	}
+
+	if (valid)
+	{
+		// Stable: pairs with the same digit keep their relative order within and across work groups.
+		uint rank = ((local_counts[digit / 2u][local_index] >> ((digit & 1u) * 16u)) & 0xFFFFu) - 1u;
+		uint destination = sort_histogram[digit * gl_NumWorkGroups.x + gl_WorkGroupID.x] + rank;
+
+		sort_pairs_out[destination] = pair;
+	}
+}
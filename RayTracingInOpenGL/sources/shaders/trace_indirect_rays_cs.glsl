@@ -0,0 +1,148 @@
+#version 460 core
+
+#include "common/scene.glsl"
+#include "common/wavefront.glsl"
+#include "common/sampler.glsl"
+#include "common/irradiance_cache.glsl"
+
+#define INDIRECT_OFF 0
+#define INDIRECT_CACHED 1
+#define INDIRECT_PATHS 2
+
+#define MAX_INDIRECT_BOUNCES 8
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+uniform ivec2 u_image_size;
+uniform vec3 u_view_position;
+
+uniform int u_indirect_mode;
+uniform int u_indirect_bounces;
+
+// Same lighting as the shadow and resolve passes, with inline shadow rays.
+vec3 direct_lighting(vec3 point, vec3 normal, uvec2 pixel_coords, uint first_dimension)
+{
+	vec3 light_diffuse_comp = vec3(1.0, 1.0, 1.0);
+	float light_diffuse_factor = 0.0;
+
+	for (int i = 0; i < u_light_count; i++)
+	{
+		vec2 u = vec2(sampler_get(pixel_coords, first_dimension + 2u * uint(i)), sampler_get(pixel_coords, first_dimension + 1u + 2u * uint(i)));
+		vec3 light_point = light_sample_point(lights[i], point, u);
+
+		vec3 light_direction = normalize(light_point - point);
+		vec3 new_origin = dot(light_direction, normal) < 0.0 ? point - (normal * u_global_threshold) : point + (normal * u_global_threshold);
+
+		if (scene_occluded(new_origin, light_direction, length(light_point - new_origin))) continue;
+
+		light_direction = normalize(lights[i].position - point);
+
+		light_diffuse_comp *= lights[i].color;
+		light_diffuse_factor += lights[i].intensity * clamp(dot(light_direction, normal), 0.0, 1.0);
+	}
+
+	return light_diffuse_comp * light_diffuse_factor;
+}
+
+void main()
+{
+	// Shader and image properties.
+	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+
+	if (pixel_coords.x >= u_image_size.x || pixel_coords.y >= u_image_size.y) return;
+
+	uint pixel = uint(pixel_coords.y * u_image_size.x + pixel_coords.x);
+
+	Surface surface = surfaces[pixel];
+
+	if (surface.performed == 0u || u_indirect_mode == INDIRECT_OFF)
+	{
+		indirect_irradiance[pixel] = vec4(0.0);
+
+		return;
+	}
+
+	uint dimensions_per_bounce = 2u + 2u * uint(u_light_count);
+
+	vec3 point = surface.point;
+	vec3 normal = dot(surface.normal, surface.point - u_view_position) > 0.0 ? -surface.normal : surface.normal;
+
+	// In the cached mode, every pixel reads the cache in place of tracing a path. The lookup is jittered over about a
+	// cell around the hit, so that neighbouring cells blend into each other as samples accumulate.
+	vec3 cached_irradiance = vec3(0.0);
+	bool cached = false;
+
+	if (u_indirect_mode == INDIRECT_CACHED)
+	{
+		vec2 u = cache_jitter(pixel);
+		vec3 tangent, bitangent;
+
+		orthonormal_basis(normal, tangent, bitangent);
+
+		float cell_size = exp2(float(cache_cell_level(point, u_view_position)));
+		vec3 lookup_point = point + cell_size * ((u.x - 0.5) * tangent + (u.y - 0.5) * bitangent);
+
+		cached = cache_query(lookup_point, normal, u_view_position, cached_irradiance);
+
+		if (cached && !cache_is_training_pixel(pixel))
+		{
+			indirect_irradiance[pixel] = vec4(cached_irradiance, 0.0);
+
+			return;
+		}
+	}
+
+	// Path vertices, the first one being the primary hit. Each bounce takes the dimensions after those of the
+	// primary pass: two for its direction, then two per light.
+	vec3 albedos[MAX_INDIRECT_BOUNCES + 1];
+	vec3 direct[MAX_INDIRECT_BOUNCES + 1];
+	uint cache_slots[MAX_INDIRECT_BOUNCES + 1];
+
+	cache_slots[0] = u_indirect_mode == INDIRECT_CACHED ? cache_find(point, normal, u_view_position, true) : 0xFFFFFFFFu;
+
+	vec3 irradiance = vec3(0.0); // Arriving at the last vertex, from the cache or nothing.
+	int vertex_count = 1;
+
+	for (int bounce = 0; bounce < min(u_indirect_bounces, MAX_INDIRECT_BOUNCES); bounce++)
+	{
+		uint dimension = dimensions_per_bounce * uint(bounce + 1);
+
+		vec2 u = vec2(sampler_get(uvec2(pixel_coords), dimension), sampler_get(uvec2(pixel_coords), dimension + 1u));
+		vec3 direction = cosine_sample_hemisphere(normal, u);
+
+		Hit hit_info = scene_intersect(point + (normal * u_global_threshold), direction);
+
+		if (!hit_info.performed) break; // The background is a backdrop, not a light.
+
+		point = hit_info.point;
+		normal = dot(hit_info.normal, direction) > 0.0 ? -hit_info.normal : hit_info.normal;
+
+		albedos[vertex_count] = material_albedo(hit_info.material, hit_info.uv);
+		direct[vertex_count] = direct_lighting(point, normal, uvec2(pixel_coords), dimension + 2u);
+		cache_slots[vertex_count] = 0xFFFFFFFFu;
+
+		vertex_count++;
+
+		// The cache stands in for the rest of the path once it knows the irradiance here, otherwise the cell is
+		// claimed and filled in from the rest of the path, unless the path ends here.
+		if (u_indirect_mode == INDIRECT_CACHED)
+		{
+			if (cache_query(point, normal, u_view_position, irradiance)) break;
+
+			if (bounce + 1 < u_indirect_bounces) cache_slots[vertex_count - 1] = cache_find(point, normal, u_view_position, true);
+		}
+	}
+
+	// Back along the path, the irradiance arriving at each vertex is the light leaving the next one.
+	for (int i = vertex_count - 1; i > 0; i--)
+	{
+		if (cache_slots[i] != 0xFFFFFFFFu) cache_add_sample(cache_slots[i], irradiance);
+
+		irradiance = albedos[i] * (direct[i] + irradiance);
+	}
+
+	if (cache_slots[0] != 0xFFFFFFFFu) cache_add_sample(cache_slots[0], irradiance);
+
+	// Training pixels show the cache like the others, the path only fills in the pixel where the cache is empty.
+	indirect_irradiance[pixel] = vec4(cached ? cached_irradiance : irradiance, 0.0);
+}
@@ -0,0 +1,68 @@
+#version 460 core
+
+#include "common/scene.glsl"
+#include "common/wavefront.glsl"
+#include "common/sampler.glsl"
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout (std430, binding = SORT_PAIRS_BINDING) writeonly buffer SortPairs { uvec2 sort_pairs[]; };
+
+uniform ivec2 u_image_size;
+uniform vec3 u_view_position;
+uniform mat4 u_view_matrix;
+
+uniform float u_fov = radians(45.0);
+
+uniform bool u_sort_rays;
+
+void main()
+{
+	// Shader and image properties.
+	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
+
+	if (pixel_coords.x >= u_image_size.x || pixel_coords.y >= u_image_size.y) return;
+
+	uint pixel = uint(pixel_coords.y * u_image_size.x + pixel_coords.x);
+
+	// Dimensions 0 and 1 jitter the ray within the pixel, then each light takes the next two.
+	vec2 jitter = vec2(sampler_get(uvec2(pixel_coords), 0u), sampler_get(uvec2(pixel_coords), 1u));
+
+	float x = (2.0 * (pixel_coords.x + jitter.x) / u_image_size.x - 1) * tan(u_fov / 2.0) * u_image_size.x / u_image_size.y;
+	float y = (2.0 * (pixel_coords.y + jitter.y) / u_image_size.y - 1) * tan(u_fov / 2.0);
+
+	vec3 view_direction = inverse(mat3(u_view_matrix)) * normalize(vec3(x, y, -1.0));
+
+	Hit hit_info = scene_intersect(u_view_position, view_direction);
+
+	surfaces[pixel].performed = hit_info.performed ? 1u : 0u;
+
+	if (!hit_info.performed) return;
+
+	surfaces[pixel].point = hit_info.point;
+	surfaces[pixel].normal = hit_info.normal;
+	surfaces[pixel].albedo = material_albedo(hit_info.material, hit_info.uv);
+
+	// One shadow ray per light, traced later by "trace_shadow_rays_cs.glsl".
+	uint first_ray = atomicAdd(shadow_ray_count, uint(u_light_count));
+
+	for (int i = 0; i < u_light_count; i++)
+	{
+		vec2 u = vec2(sampler_get(uvec2(pixel_coords), 2u + 2u * uint(i)), sampler_get(uvec2(pixel_coords), 3u + 2u * uint(i)));
+		vec3 light_point = light_sample_point(lights[i], hit_info.point, u);
+
+		vec3 light_direction = normalize(light_point - hit_info.point);
+		vec3 new_origin = dot(light_direction, hit_info.normal) < 0.0 ? hit_info.point - (hit_info.normal * u_global_threshold) : hit_info.point + (hit_info.normal * u_global_threshold);
+
+		uint ray_index = first_ray + uint(i);
+
+		shadow_rays[ray_index].origin = new_origin;
+		shadow_rays[ray_index].slot = pixel * uint(u_light_count) + uint(i);
+		shadow_rays[ray_index].direction = light_direction;
+		shadow_rays[ray_index].max_distance = length(light_point - new_origin);
+
+		sort_pairs[ray_index] = uvec2(u_sort_rays ? ray_sort_key(new_origin, light_direction) : 0u, ray_index);
+
+		visibility[pixel * uint(u_light_count) + uint(i)] = 0u;
+	}
+}
@@ -0,0 +1,20 @@
+#version 460 core
+
+#include "common/scene.glsl"
+#include "common/wavefront.glsl"
+
+layout (local_size_x = SORT_GROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+layout (std430, binding = SORT_PAIRS_BINDING) readonly buffer SortPairs { uvec2 sort_pairs[]; };
+
+void main()
+{
+	uint pair_index = gl_GlobalInvocationID.x;
+
+	if (pair_index >= shadow_ray_count) return;
+
+	// Consecutive invocations trace consecutive rays of the (possibly sorted) order.
+	ShadowRay ray = shadow_rays[sort_pairs[pair_index].y];
+
+	visibility[ray.slot] = scene_occluded(ray.origin, ray.direction, ray.max_distance) ? 0u : 1u;
+}
@@ -0,0 +1,46 @@
+#version 460 core
+
+#include "common/irradiance_cache.glsl"
+
+layout (local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+uniform uint u_cache_max_samples;
+uniform uint u_cache_max_age;
+
+uniform bool u_cache_invalidate;
+uniform vec3 u_cache_invalidate_min;
+uniform vec3 u_cache_invalidate_max;
+
+void main()
+{
+	uint slot = gl_GlobalInvocationID.x;
+
+	if (slot >= CACHE_CAPACITY) return;
+
+	CacheCell cell = cache_cells[slot];
+	uvec4 accumulator = cache_accumulators[slot];
+
+	if (cell.key == 0u) return;
+
+	cache_accumulators[slot] = uvec4(0u);
+
+	bool invalidated = u_cache_invalidate && all(greaterThanEqual(cell.center + cell.half_size, u_cache_invalidate_min))
+		&& all(lessThanEqual(cell.center - cell.half_size, u_cache_invalidate_max));
+
+	if (invalidated || u_cache_frame - cell.last_frame > u_cache_max_age)
+	{
+		cache_cells[slot].key = 0u;
+		cache_cells[slot].sample_count = 0u;
+
+		return;
+	}
+
+	if (accumulator.w == 0u) return;
+
+	// Running average over at most the last "u_cache_max_samples" samples, so that cells keep following the lighting.
+	vec3 mean = vec3(accumulator.xyz) / (CACHE_FIXED_POINT_SCALE * float(accumulator.w));
+	uint sample_count = min(cell.sample_count + accumulator.w, u_cache_max_samples);
+
+	cache_cells[slot].irradiance = mix(cell.irradiance, mean, min(float(accumulator.w) / float(sample_count), 1.0));
+	cache_cells[slot].sample_count = sample_count;
+}
@@ -0,0 +1,567 @@
+#include "bvh.h"
+
+static const int SAH_BINS = 16;
+static const int MAX_SAH_DEPTH = 40; // Deeper nodes are split at the median, which bounds the depth of the tree.
+
+static float surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+Bvh::Bvh(const Scene& scene)
+	: wideDepth(0)
+{
+	std::vector<Primitive> buildPrimitives = gatherPrimitives(scene);
+
+	if (buildPrimitives.empty()) return;
+
+	// The traversal stacks have a fixed size, so a tree too deep for them is built again with median splits only,
+	// whose depth is logarithmic in the number of primitives and always fits.
+	if (!buildLayouts(buildPrimitives, MAX_SAH_DEPTH))
+	{
+		std::cout << "[INFO] BVH: The SAH tree is too deep for the traversal stacks, building it with median splits." << std::endl;
+
+		buildLayouts(buildPrimitives, 0);
+	}
+
+	float binarySize = (float)(nodes.size() * sizeof(BvhNode)) / 1024.0f;
+	float wideSize = (float)(wideNodes.size() * sizeof(WideBvhNode)) / 1024.0f;
+
+	std::cout << "[INFO] BVH: " << primitives.size() << " primitives | binary nodes " << binarySize << " KB | wide nodes "
+		<< wideSize << " KB (" << binarySize / wideSize << "x smaller, depth " << wideDepth << ")." << std::endl;
+}
+
+Bvh::Bvh(std::vector<BvhNode>&& nodes, std::vector<unsigned int>&& primitives, std::vector<WideBvhNode>&& wideNodes, std::vector<unsigned int>&& widePrimitives, int wideDepth)
+	: nodes(std::move(nodes)), primitives(std::move(primitives)), wideNodes(std::move(wideNodes)), widePrimitives(std::move(widePrimitives)), wideDepth(wideDepth)
+{
+}
+
+const std::vector<BvhNode>& Bvh::getNodes()
+{
+	return nodes;
+}
+
+const std::vector<unsigned int>& Bvh::getPrimitives()
+{
+	return primitives;
+}
+
+const std::vector<WideBvhNode>& Bvh::getWideNodes()
+{
+	return wideNodes;
+}
+
+const std::vector<unsigned int>& Bvh::getWidePrimitives()
+{
+	return widePrimitives;
+}
+
+int Bvh::getWideDepth()
+{
+	return wideDepth;
+}
+
+int Bvh::validate(const Scene& scene, int rayCount) const
+{
+	std::vector<Primitive> scenePrimitives = gatherPrimitives(scene);
+
+	// References index the scene arrays by type, which follow each other in "scenePrimitives".
+	unsigned int typeOffsets[3] = { 0, (unsigned int)scene.spheres.size(), (unsigned int)(scene.spheres.size() + scene.planes.size()) };
+
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	std::normal_distribution<float> normal(0.0f, 1.0f);
+
+	glm::vec3 sceneMin, sceneMax;
+
+	scene.computeBounds(sceneMin, sceneMax);
+
+	glm::vec3 sceneSize = sceneMax - sceneMin;
+	int mismatches = 0;
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		// Origins all over the scene bounds (and a bit around them) with uniformly distributed directions.
+		glm::vec3 origin = sceneMin - sceneSize * 0.1f + sceneSize * 1.2f * glm::vec3(uniform(generator), uniform(generator), uniform(generator));
+		glm::vec3 direction = glm::normalize(glm::vec3(normal(generator), normal(generator), normal(generator)) + glm::vec3(1e-6f));
+		glm::vec3 inverse = inverseDirection(direction);
+
+		float maxDistance = glm::length(sceneSize) * uniform(generator);
+
+		// Entry distance into the bounds of a primitive, negative when the ray misses them.
+		auto entry = [&](unsigned int reference, float limit)
+		{
+			const Primitive& primitive = scenePrimitives[typeOffsets[reference >> PRIMITIVE_TYPE_SHIFT] + (reference & PRIMITIVE_INDEX_MASK)];
+
+			if (!intersectBounds(origin, inverse, primitive.boundsMin, primitive.boundsMax, limit)) return -1.0f;
+
+			glm::vec3 t0 = (primitive.boundsMin - origin) * inverse;
+			glm::vec3 t1 = (primitive.boundsMax - origin) * inverse;
+			glm::vec3 tNear = glm::min(t0, t1);
+
+			return std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		};
+
+		// Brute force, then the binary layout (when there is one) and the wide layout.
+		float distances[3] = { 1e32f, 1e32f, 1e32f };
+		bool occluded[3] = { false, false, false };
+
+		for (const Primitive& primitive : scenePrimitives)
+		{
+			float distance = entry(primitive.reference, 1e32f);
+
+			if (distance >= 0.0f) distances[0] = std::min(distances[0], distance);
+
+			occluded[0] = occluded[0] || (distance >= 0.0f && distance <= maxDistance);
+		}
+
+		auto closest = [&](int layout)
+		{
+			return [&, layout](unsigned int reference, float& closestDistance)
+			{
+				float distance = entry(reference, closestDistance);
+
+				if (distance >= 0.0f && distance < closestDistance)
+				{
+					closestDistance = distance;
+					distances[layout] = distance;
+				}
+
+				return false;
+			};
+		};
+
+		auto any = [&](int layout)
+		{
+			return [&, layout](unsigned int reference, float& limit)
+			{
+				occluded[layout] = entry(reference, limit) >= 0.0f;
+
+				return occluded[layout];
+			};
+		};
+
+		if (!nodes.empty())
+		{
+			traverse(origin, direction, 1e32f, closest(1));
+			traverse(origin, direction, maxDistance, any(1));
+		}
+		else
+		{
+			distances[1] = distances[0];
+			occluded[1] = occluded[0];
+		}
+
+		traverseWide(origin, direction, 1e32f, closest(2));
+		traverseWide(origin, direction, maxDistance, any(2));
+
+		// Distances rather than primitives are compared, since ties may be broken differently.
+		if (distances[1] != distances[0] || distances[2] != distances[0] || occluded[1] != occluded[0] || occluded[2] != occluded[0])
+		{
+			mismatches += 1;
+		}
+	}
+
+	if (mismatches == 0)
+	{
+		std::cout << "[INFO] BVH: Both layouts find the same hits as a brute force search on " << rayCount << " random rays." << std::endl;
+	}
+	else
+	{
+		std::cout << "[ERROR] BVH: The layouts disagree with a brute force search on " << mismatches << " of " << rayCount << " random rays." << std::endl;
+	}
+
+	return mismatches;
+}
+
+std::vector<Bvh::Primitive> Bvh::gatherPrimitives(const Scene& scene)
+{
+	std::vector<Primitive> scenePrimitives;
+
+	for (unsigned int i = 0; i < scene.spheres.size(); i++)
+	{
+		const Sphere& sphere = scene.spheres[i];
+
+		scenePrimitives.push_back({ sphere.center - sphere.radius, sphere.center + sphere.radius, sphere.center, (PRIMITIVE_SPHERE << PRIMITIVE_TYPE_SHIFT) | i });
+	}
+
+	for (unsigned int i = 0; i < scene.planes.size(); i++)
+	{
+		const Plane& plane = scene.planes[i];
+
+		glm::vec3 boundsMin(-plane.xSize, plane.yPosition, -plane.zSize);
+		glm::vec3 boundsMax(plane.xSize, plane.yPosition, plane.zSize);
+
+		scenePrimitives.push_back({ boundsMin, boundsMax, (boundsMin + boundsMax) * 0.5f, (PRIMITIVE_PLANE << PRIMITIVE_TYPE_SHIFT) | i });
+	}
+
+	for (unsigned int i = 0; i < scene.triangles.size(); i++)
+	{
+		const Triangle& triangle = scene.triangles[i];
+
+		glm::vec3 boundsMin = glm::min(triangle.vertex0, glm::min(triangle.vertex1, triangle.vertex2));
+		glm::vec3 boundsMax = glm::max(triangle.vertex0, glm::max(triangle.vertex1, triangle.vertex2));
+
+		scenePrimitives.push_back({ boundsMin, boundsMax, (boundsMin + boundsMax) * 0.5f, (PRIMITIVE_TRIANGLE << PRIMITIVE_TYPE_SHIFT) | i });
+	}
+
+	return scenePrimitives;
+}
+
+bool Bvh::buildLayouts(std::vector<Primitive>& buildPrimitives, int sahDepth)
+{
+	nodes.clear();
+	wideNodes.clear();
+	widePrimitives.clear();
+
+	wideDepth = 0;
+
+	nodes.reserve(buildPrimitives.size() * 2);
+	nodes.push_back(BvhNode());
+
+	int depth = build(buildPrimitives, 0, 0, (int)buildPrimitives.size(), 0, sahDepth);
+
+	primitives.resize(buildPrimitives.size());
+
+	for (size_t i = 0; i < buildPrimitives.size(); i++)
+	{
+		primitives[i] = buildPrimitives[i].reference;
+	}
+
+	// Children are always stored after their parent, so a reverse sweep counts the leaves below every node.
+	std::vector<int> leafCounts(nodes.size());
+
+	for (int i = (int)nodes.size() - 1; i >= 0; i--)
+	{
+		leafCounts[i] = nodes[i].count > 0 ? 1 : leafCounts[nodes[i].leftFirst] + leafCounts[nodes[i].leftFirst + 1];
+	}
+
+	wideNodes.push_back(WideBvhNode());
+	widePrimitives.reserve(primitives.size());
+
+	collapse(leafCounts, 0, 0, 1);
+
+	// The binary traversal holds at most one entry per level plus the sibling of the current node, the wide one at
+	// most one per level.
+	return depth < STACK_SIZE && wideDepth <= WIDE_STACK_SIZE;
+}
+
+int Bvh::build(std::vector<Primitive>& buildPrimitives, int nodeIndex, int first, int count, int depth, int sahDepth)
+{
+	glm::vec3 boundsMin(1e32f), boundsMax(-1e32f), centroidMin(1e32f), centroidMax(-1e32f);
+
+	for (int i = first; i < first + count; i++)
+	{
+		boundsMin = glm::min(boundsMin, buildPrimitives[i].boundsMin);
+		boundsMax = glm::max(boundsMax, buildPrimitives[i].boundsMax);
+		centroidMin = glm::min(centroidMin, buildPrimitives[i].centroid);
+		centroidMax = glm::max(centroidMax, buildPrimitives[i].centroid);
+	}
+
+	nodes[nodeIndex].boundsMin = boundsMin;
+	nodes[nodeIndex].boundsMax = boundsMax;
+
+	if (count == 1)
+	{
+		nodes[nodeIndex].leftFirst = first;
+		nodes[nodeIndex].count = count;
+
+		return depth;
+	}
+
+	// Binned SAH over the centroids, with unit traversal and intersection costs.
+	int bestAxis = -1, bestBin = 0;
+	float bestCost = 1e32f;
+
+	for (int axis = 0; axis < 3 && depth < sahDepth; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+
+		if (extent <= 0.0f) continue;
+
+		glm::vec3 binMin[SAH_BINS], binMax[SAH_BINS];
+		int binCount[SAH_BINS] = {};
+
+		for (int i = 0; i < SAH_BINS; i++)
+		{
+			binMin[i] = glm::vec3(1e32f);
+			binMax[i] = glm::vec3(-1e32f);
+		}
+
+		for (int i = first; i < first + count; i++)
+		{
+			int bin = std::min((int)((buildPrimitives[i].centroid[axis] - centroidMin[axis]) / extent * SAH_BINS), SAH_BINS - 1);
+
+			binMin[bin] = glm::min(binMin[bin], buildPrimitives[i].boundsMin);
+			binMax[bin] = glm::max(binMax[bin], buildPrimitives[i].boundsMax);
+			binCount[bin] += 1;
+		}
+
+		float rightArea[SAH_BINS];
+		glm::vec3 sweepMin(1e32f), sweepMax(-1e32f);
+
+		for (int i = SAH_BINS - 1; i > 0; i--)
+		{
+			sweepMin = glm::min(sweepMin, binMin[i]);
+			sweepMax = glm::max(sweepMax, binMax[i]);
+
+			rightArea[i] = surfaceArea(sweepMin, sweepMax);
+		}
+
+		sweepMin = glm::vec3(1e32f);
+		sweepMax = glm::vec3(-1e32f);
+
+		int leftCount = 0;
+
+		for (int i = 0; i < SAH_BINS - 1; i++)
+		{
+			sweepMin = glm::min(sweepMin, binMin[i]);
+			sweepMax = glm::max(sweepMax, binMax[i]);
+			leftCount += binCount[i];
+
+			if (leftCount == 0 || leftCount == count) continue;
+
+			float cost = surfaceArea(sweepMin, sweepMax) * leftCount + rightArea[i + 1] * (count - leftCount);
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+			}
+		}
+	}
+
+	float nodeArea = surfaceArea(boundsMin, boundsMax);
+
+	if (count <= MAX_LEAF_SIZE && (bestAxis < 0 || count * nodeArea <= nodeArea + bestCost))
+	{
+		nodes[nodeIndex].leftFirst = first;
+		nodes[nodeIndex].count = count;
+
+		return depth;
+	}
+
+	int middle;
+
+	if (bestAxis >= 0)
+	{
+		float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+
+		Primitive* split = std::partition(buildPrimitives.data() + first, buildPrimitives.data() + first + count, [&](const Primitive& primitive)
+		{
+			return std::min((int)((primitive.centroid[bestAxis] - centroidMin[bestAxis]) / extent * SAH_BINS), SAH_BINS - 1) <= bestBin;
+		});
+
+		middle = (int)(split - buildPrimitives.data());
+	}
+	else
+	{
+		// Coincident centroids or too deep: split at the median of the widest centroid axis.
+		glm::vec3 extent = centroidMax - centroidMin;
+		int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+		middle = first + count / 2;
+
+		std::nth_element(buildPrimitives.begin() + first, buildPrimitives.begin() + middle, buildPrimitives.begin() + first + count, [axis](const Primitive& a, const Primitive& b)
+		{
+			return a.centroid[axis] < b.centroid[axis];
+		});
+	}
+
+	int leftIndex = (int)nodes.size();
+
+	nodes.push_back(BvhNode());
+	nodes.push_back(BvhNode());
+
+	nodes[nodeIndex].leftFirst = leftIndex;
+	nodes[nodeIndex].count = 0;
+
+	int leftDepth = build(buildPrimitives, leftIndex, first, middle - first, depth + 1, sahDepth);
+	int rightDepth = build(buildPrimitives, leftIndex + 1, middle, first + count - middle, depth + 1, sahDepth);
+
+	return std::max(leftDepth, rightDepth);
+}
+
+void Bvh::collapse(const std::vector<int>& leafCounts, int nodeIndex, int wideNodeIndex, int depth)
+{
+	wideDepth = std::max(wideDepth, depth);
+
+	// Open interior children until there are as many as the wide node has slots. Children whose own children are
+	// leaves go first, since opening them does not leave any subtree behind, which would need a mostly empty wide
+	// node of its own; otherwise the subtree with the most leaves goes first, which keeps the tree balanced.
+	std::vector<int> children;
+
+	if (nodes[nodeIndex].count > 0)
+	{
+		children.push_back(nodeIndex);
+	}
+	else
+	{
+		children.push_back(nodes[nodeIndex].leftFirst);
+		children.push_back(nodes[nodeIndex].leftFirst + 1);
+	}
+
+	auto interiorChildren = [this](int node)
+	{
+		return (nodes[nodes[node].leftFirst].count == 0 ? 1 : 0) + (nodes[nodes[node].leftFirst + 1].count == 0 ? 1 : 0);
+	};
+
+	while ((int)children.size() < WIDTH)
+	{
+		int best = -1;
+
+		for (int i = 0; i < (int)children.size(); i++)
+		{
+			if (nodes[children[i]].count > 0) continue;
+
+			if (best < 0)
+			{
+				best = i;
+
+				continue;
+			}
+
+			int interior = interiorChildren(children[i]), bestInterior = interiorChildren(children[best]);
+
+			if (interior < bestInterior || (interior == bestInterior && leafCounts[children[i]] > leafCounts[children[best]]))
+			{
+				best = i;
+			}
+		}
+
+		if (best < 0) break;
+
+		int opened = children[best];
+
+		children[best] = nodes[opened].leftFirst;
+		children.push_back(nodes[opened].leftFirst + 1);
+	}
+
+	// Greedy slot assignment: the child in slot s should come first for rays going towards the axes set in s.
+	const BvhNode& parent = nodes[nodeIndex];
+	glm::vec3 parentCentroid = (parent.boundsMin + parent.boundsMax) * 0.5f;
+
+	int slots[WIDTH];
+	bool assigned[WIDTH] = {};
+	bool occupied[WIDTH] = {};
+
+	for (int n = 0; n < (int)children.size(); n++)
+	{
+		int bestChild = -1, bestSlot = -1;
+		float bestCost = 1e32f;
+
+		for (int i = 0; i < (int)children.size(); i++)
+		{
+			if (assigned[i]) continue;
+
+			glm::vec3 offset = (nodes[children[i]].boundsMin + nodes[children[i]].boundsMax) * 0.5f - parentCentroid;
+
+			for (int s = 0; s < WIDTH; s++)
+			{
+				if (occupied[s]) continue;
+
+				float cost = 0.0f;
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					cost += ((s >> axis) & 1) ? offset[axis] : -offset[axis];
+				}
+
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestChild = i;
+					bestSlot = s;
+				}
+			}
+		}
+
+		slots[bestChild] = bestSlot;
+		assigned[bestChild] = true;
+		occupied[bestSlot] = true;
+	}
+
+	WideBvhNode wideNode = {};
+
+	// Per axis power of two scale so that the 255 steps from the origin cover the node.
+	wideNode.origin = parent.boundsMin;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = parent.boundsMax[axis] - parent.boundsMin[axis];
+		int exponent = extent > 0.0f ? (int)std::ceil(std::log2(extent / 255.0f)) : -100;
+
+		exponent = std::max(exponent, -100);
+
+		while (wideNode.origin[axis] + 255.0f * std::ldexp(1.0f, exponent) < parent.boundsMax[axis]) exponent++;
+
+		wideNode.exponents[axis] = (signed char)exponent;
+	}
+
+	glm::vec3 scale(std::ldexp(1.0f, wideNode.exponents[0]), std::ldexp(1.0f, wideNode.exponents[1]), std::ldexp(1.0f, wideNode.exponents[2]));
+
+	// Interior children are allocated first, in slot order.
+	int internalChildren[WIDTH];
+	int internalCount = 0;
+
+	wideNode.childBase = (unsigned int)wideNodes.size();
+	wideNode.primitiveBase = (unsigned int)widePrimitives.size();
+
+	for (int s = 0; s < WIDTH; s++)
+	{
+		int i = 0;
+
+		while (i < (int)children.size() && !(assigned[i] && slots[i] == s)) i++;
+
+		if (i == (int)children.size()) continue;
+
+		const BvhNode& child = nodes[children[i]];
+
+		// Rounded outwards, checked against the exact decoding used by the traversals.
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float origin = wideNode.origin[axis];
+
+			int low = (int)std::floor((child.boundsMin[axis] - origin) / scale[axis]);
+			int high = (int)std::ceil((child.boundsMax[axis] - origin) / scale[axis]);
+
+			low = glm::clamp(low, 0, 255);
+			high = glm::clamp(high, 0, 255);
+
+			while (low > 0 && origin + (float)low * scale[axis] > child.boundsMin[axis]) low--;
+			while (high < 255 && origin + (float)high * scale[axis] < child.boundsMax[axis]) high++;
+
+			wideNode.quantizedMin[axis][s] = (unsigned char)low;
+			wideNode.quantizedMax[axis][s] = (unsigned char)high;
+		}
+
+		if (child.count == 0)
+		{
+			wideNode.internalMask |= (unsigned char)(1u << s);
+
+			internalChildren[internalCount++] = children[i];
+		}
+		else
+		{
+			unsigned int offset = (unsigned int)widePrimitives.size() - wideNode.primitiveBase;
+
+			wideNode.meta[s] = (unsigned char)((child.count << 5) | offset);
+
+			for (unsigned int j = 0; j < child.count; j++)
+			{
+				widePrimitives.push_back(primitives[child.leftFirst + j]);
+			}
+		}
+	}
+
+	wideNodes.resize(wideNodes.size() + internalCount);
+	wideNodes[wideNodeIndex] = wideNode;
+
+	for (int i = 0; i < internalCount; i++)
+	{
+		collapse(leafCounts, internalChildren[i], wideNode.childBase + i, depth + 1);
+	}
+}
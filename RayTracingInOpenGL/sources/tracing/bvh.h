@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "scene.h"
+
+// Primitives are referenced by their type in the top bits and their index in the matching scene array below.
+#define PRIMITIVE_TYPE_SHIFT 30
+#define PRIMITIVE_INDEX_MASK 0x3FFFFFFFu
+
+enum PrimitiveType { PRIMITIVE_SPHERE, PRIMITIVE_PLANE, PRIMITIVE_TRIANGLE };
+
+// Binary BVH node with full precision bounds (32 bytes). Interior nodes store the index of their left child, the
+// right one follows it; leaves store the first of their "count" primitive references.
+struct BvhNode
+{
+	glm::vec3 boundsMin;
+	unsigned int leftFirst;
+	glm::vec3 boundsMax;
+	unsigned int count;
+};
+
+// 8-wide node whose child bounds are quantized to 8 bits per plane relative to the node bounds (80 bytes).
+// The layout matches "WideBvhNode" in "shaders/common/scene.glsl".
+//
+// A child box is "origin + quantized * 2^exponent" per axis, rounded outwards when quantizing, so it always contains
+// the full precision box. Interior children are stored contiguously from "childBase" in slot order, so the child in
+// slot s is at "childBase + popcount(internalMask & ((1 << s) - 1))". A leaf slot stores its primitive count in the
+// top 3 bits of its meta byte and the offset of its first primitive from "primitiveBase" in the low 5 bits; a meta
+// byte of 0 marks an empty slot.
+//
+// Slots are assigned so that the child in slot s tends to be the nearest one for rays going towards +x, +y, +z
+// where bits 0, 1, 2 of s are set, so visiting slot "k ^ octant" for k = 0..7 is roughly front to back.
+struct WideBvhNode
+{
+	glm::vec3 origin;
+	signed char exponents[3];
+	unsigned char internalMask;
+	unsigned int childBase;
+	unsigned int primitiveBase;
+	unsigned char meta[8];
+	unsigned char quantizedMin[3][8]; // Indexed by axis and slot.
+	unsigned char quantizedMax[3][8];
+};
+
+class Bvh
+{
+public:
+	static const int WIDTH = 8;
+	static const int MAX_LEAF_SIZE = 4; // Leaf counts must fit the 3 bits of a meta byte, and 8 leaves 32 offsets.
+	// Trees deeper than the traversal stacks allow are never built, see buildLayouts().
+	static const int STACK_SIZE = 64;
+	static const int WIDE_STACK_SIZE = 32; // Must match "BVH_STACK_SIZE" in "shaders/common/scene.glsl".
+
+	Bvh(const Scene& scene);
+
+	// Adopts prebuilt layouts, such as the ones stored in a scene file, whose indices and depth must have been checked
+	// (see loadSceneFile()). The binary layout may be empty, in which case only the wide traversal is available.
+	Bvh(std::vector<BvhNode>&& nodes, std::vector<unsigned int>&& primitives, std::vector<WideBvhNode>&& wideNodes, std::vector<unsigned int>&& widePrimitives, int wideDepth);
+
+	const std::vector<BvhNode>& getNodes();
+	const std::vector<unsigned int>& getPrimitives();
+
+	const std::vector<WideBvhNode>& getWideNodes();
+	const std::vector<unsigned int>& getWidePrimitives();
+
+	int getWideDepth(); // Levels of the wide tree, which bounds the traversal stack size.
+
+	// Both traversals call "intersect(primitive, maxDistance)" on every primitive reached, which shortens
+	// "maxDistance" on a closer hit and returns true to end the traversal early (any hit queries).
+	template <typename Intersect> void traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Intersect intersect) const;
+	template <typename Intersect> void traverseWide(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Intersect intersect) const;
+
+	// Traces random rays through both layouts and through every primitive of "scene", and returns the number of rays
+	// on which they disagree about the closest hit or about occlusion. Primitives are hit where a ray enters their
+	// bounds, so the check depends on the trees only and needs neither a renderer nor an OpenGL context.
+	int validate(const Scene& scene, int rayCount) const;
+
+	static glm::vec3 inverseDirection(const glm::vec3& direction);
+	static bool intersectBounds(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float maxDistance);
+
+private:
+	struct Primitive
+	{
+		glm::vec3 boundsMin, boundsMax, centroid;
+
+		unsigned int reference;
+	};
+
+	std::vector<BvhNode> nodes;
+	std::vector<unsigned int> primitives;
+
+	std::vector<WideBvhNode> wideNodes;
+	std::vector<unsigned int> widePrimitives;
+
+	int wideDepth;
+
+	static std::vector<Primitive> gatherPrimitives(const Scene& scene); // Spheres, then planes, then triangles.
+
+	bool buildLayouts(std::vector<Primitive>& buildPrimitives, int sahDepth); // False if too deep for the stacks.
+	int build(std::vector<Primitive>& buildPrimitives, int nodeIndex, int first, int count, int depth, int sahDepth);
+	void collapse(const std::vector<int>& leafCounts, int nodeIndex, int wideNodeIndex, int depth);
+};
+
+inline glm::vec3 Bvh::inverseDirection(const glm::vec3& direction)
+{
+	// Keeps the slab distances finite, so that they never turn into NaNs against boxes flat on the ray origin.
+	glm::vec3 inverse;
+
+	for (int i = 0; i < 3; i++)
+	{
+		inverse[i] = 1.0f / (std::abs(direction[i]) > 1e-20f ? direction[i] : (direction[i] < 0.0f ? -1e-20f : 1e-20f));
+	}
+
+	return inverse;
+}
+
+inline bool Bvh::intersectBounds(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float maxDistance)
+{
+	glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+	glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+
+	float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+	return entry <= exit;
+}
+
+template <typename Intersect>
+void Bvh::traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Intersect intersect) const
+{
+	if (nodes.empty()) return;
+
+	glm::vec3 inverse = inverseDirection(direction);
+
+	unsigned int stack[STACK_SIZE];
+	int stackSize = 0;
+
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const BvhNode& node = nodes[stack[--stackSize]];
+
+		if (!intersectBounds(origin, inverse, node.boundsMin, node.boundsMax, maxDistance)) continue;
+
+		if (node.count > 0)
+		{
+			for (unsigned int i = 0; i < node.count; i++)
+			{
+				if (intersect(primitives[node.leftFirst + i], maxDistance)) return;
+			}
+		}
+		else if (stackSize + 2 <= STACK_SIZE)
+		{
+			stack[stackSize++] = node.leftFirst + 1;
+			stack[stackSize++] = node.leftFirst;
+		}
+	}
+}
+
+template <typename Intersect>
+void Bvh::traverseWide(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Intersect intersect) const
+{
+	// Mirror of "bvh_traverse()" in "shaders/common/scene.glsl".
+	if (wideNodes.empty()) return;
+
+	glm::vec3 inverse = inverseDirection(direction);
+
+	unsigned int octant = (direction.x >= 0.0f ? 1u : 0u) | (direction.y >= 0.0f ? 2u : 0u) | (direction.z >= 0.0f ? 4u : 0u);
+
+	// Each entry holds the child base of a node and, above its internal mask, the hit interior children still to
+	// visit, in visiting order.
+	unsigned int stack[WIDE_STACK_SIZE][2];
+	int stackSize = 0;
+
+	unsigned int nodeIndex = 0;
+	bool hasNode = true;
+
+	while (true)
+	{
+		if (hasNode)
+		{
+			const WideBvhNode& node = wideNodes[nodeIndex];
+
+			glm::vec3 scale;
+
+			for (int i = 0; i < 3; i++)
+			{
+				scale[i] = std::ldexp(1.0f, node.exponents[i]);
+			}
+
+			unsigned int hits = 0;
+
+			for (unsigned int k = 0; k < WIDTH; k++)
+			{
+				unsigned int slot = k ^ octant;
+
+				bool internal = (node.internalMask >> slot) & 1u;
+
+				if (!internal && node.meta[slot] == 0) continue;
+
+				glm::vec3 boundsMin(node.quantizedMin[0][slot], node.quantizedMin[1][slot], node.quantizedMin[2][slot]);
+				glm::vec3 boundsMax(node.quantizedMax[0][slot], node.quantizedMax[1][slot], node.quantizedMax[2][slot]);
+
+				if (!intersectBounds(origin, inverse, node.origin + boundsMin * scale, node.origin + boundsMax * scale, maxDistance)) continue;
+
+				if (internal)
+				{
+					hits |= 1u << k;
+				}
+				else
+				{
+					unsigned int first = node.primitiveBase + (node.meta[slot] & 31u);
+					unsigned int count = node.meta[slot] >> 5;
+
+					for (unsigned int i = 0; i < count; i++)
+					{
+						if (intersect(widePrimitives[first + i], maxDistance)) return;
+					}
+				}
+			}
+
+			// Trees are never deeper than the stack, the check only keeps a broken one from writing past it.
+			if (hits != 0 && stackSize < WIDE_STACK_SIZE)
+			{
+				stack[stackSize][0] = node.childBase;
+				stack[stackSize][1] = (hits << 8) | node.internalMask;
+				stackSize += 1;
+			}
+
+			hasNode = false;
+		}
+
+		if (stackSize == 0) return;
+
+		unsigned int* entry = stack[stackSize - 1];
+		unsigned int hits = entry[1] >> 8;
+		unsigned int k = 0;
+
+		while (!((hits >> k) & 1u)) k++;
+
+		entry[1] &= ~(1u << (k + 8));
+
+		if ((entry[1] >> 8) == 0) stackSize -= 1;
+
+		unsigned int slot = k ^ octant;
+		unsigned int below = entry[1] & 0xFFu & ((1u << slot) - 1u);
+		unsigned int offset = 0;
+
+		for (; below != 0; below &= below - 1) offset++;
+
+		nodeIndex = entry[0] + offset;
+		hasNode = true;
+	}
+}
@@ -0,0 +1,339 @@
+#include "convergence_benchmark.h"
+
+ConvergenceBenchmark::ConvergenceBenchmark(const Scene& scene, int width, int height, Texture* outputTex)
+	: scene(scene), width(width), height(height), outputTex(outputTex), reference(), image(width * height), referenceSamples(0),
+	  backendSamples(0), backendRmse(0.0), backendsMatch(true), backendsChecked(false)
+{
+}
+
+void ConvergenceBenchmark::addConfiguration(Renderer* renderer, Sampler::Type sampler, bool sortRays, Renderer::IndirectMode indirectMode)
+{
+	configurations.push_back({ renderer, sampler, sortRays, indirectMode });
+}
+
+bool ConvergenceBenchmark::prepareReference(Renderer* referenceRenderer, Camera& camera, float fov, unsigned int samples, const char* filepath)
+{
+	size_t pixelCount = (size_t)width * height;
+	unsigned long long key = computeKey(camera, fov);
+
+	std::ifstream inputStream(filepath, std::ios::binary);
+
+	if (inputStream)
+	{
+		ReferenceHeader header;
+
+		inputStream.read((char*)&header, sizeof(header));
+
+		if (inputStream && memcmp(header.magic, "RTREF", 6) == 0 && header.version == REFERENCE_VERSION && header.width == (unsigned int)width &&
+			header.height == (unsigned int)height && header.samples == samples && header.key == key)
+		{
+			reference.resize(pixelCount);
+
+			inputStream.read((char*)reference.data(), pixelCount * sizeof(glm::vec4));
+
+			if (inputStream)
+			{
+				referenceSamples = samples;
+
+				std::cout << "[INFO] CONVERGENCE BENCHMARK: Reusing the " << samples << " spp reference in \"" << filepath << "\"." << std::endl;
+
+				return true;
+			}
+		}
+
+		std::cout << "[INFO] CONVERGENCE BENCHMARK: \"" << filepath << "\" does not match the current setup, rendering a new reference." << std::endl;
+	}
+
+	inputStream.close();
+
+	std::cout << "[INFO] CONVERGENCE BENCHMARK: Rendering a " << samples << " spp reference with the " << referenceRenderer->getName() << " backend." << std::endl;
+
+	Clock::time_point start = Clock::now();
+
+	referenceRenderer->setSortRays(false);
+	referenceRenderer->setSampler(Sampler::SOBOL);
+	referenceRenderer->setIndirectMode(Renderer::INDIRECT_PATHS);
+
+	for (unsigned int i = 0; i < samples; i++)
+	{
+		renderSample(referenceRenderer, camera, fov);
+
+		if ((i + 1) % std::max(samples / 10, 1u) == 0)
+		{
+			std::cout << "[INFO] CONVERGENCE BENCHMARK: Reference " << (i + 1) << "/" << samples << " spp." << std::endl;
+		}
+	}
+
+	if (referenceRenderer->getSampleCount() != samples)
+	{
+		std::cout << "[ERROR] CONVERGENCE BENCHMARK: The reference restarted its accumulation, the view must not change while rendering it." << std::endl;
+
+		return false;
+	}
+
+	reference.resize(pixelCount);
+	readImage(reference);
+
+	referenceSamples = samples;
+
+	float seconds = std::chrono::duration<float>(Clock::now() - start).count();
+
+	std::cout << "[INFO] CONVERGENCE BENCHMARK: Reference rendered in " << seconds << " s." << std::endl;
+
+	ReferenceHeader header = {};
+
+	memcpy(header.magic, "RTREF", 6);
+	header.version = REFERENCE_VERSION;
+	header.width = width;
+	header.height = height;
+	header.samples = samples;
+	header.key = key;
+
+	std::ofstream outputStream(filepath, std::ios::binary);
+
+	outputStream.write((const char*)&header, sizeof(header));
+	outputStream.write((const char*)reference.data(), pixelCount * sizeof(glm::vec4));
+
+	if (!outputStream)
+	{
+		// Not fatal, the reference is only rendered again next time.
+		std::cout << "[ERROR] CONVERGENCE BENCHMARK: Failed to write \"" << filepath << "\"." << std::endl;
+	}
+
+	return true;
+}
+
+void ConvergenceBenchmark::run(Camera& camera, float fov, const std::vector<float>& budgetsSeconds)
+{
+	curves.assign(configurations.size(), std::vector<Point>());
+
+	if (reference.empty() || budgetsSeconds.empty()) return;
+
+	for (size_t i = 0; i < configurations.size(); i++)
+	{
+		const Configuration& configuration = configurations[i];
+
+		configuration.renderer->setSortRays(configuration.sortRays);
+		configuration.renderer->setSampler(configuration.sampler);
+		configuration.renderer->setIndirectMode(configuration.indirectMode);
+
+		// The cache would otherwise still hold what the previous configurations of the same backend filled in.
+		configuration.renderer->clearCache();
+
+		// One untimed sample first, so that shader compilation, first-use allocations and caches are not measured.
+		renderSample(configuration.renderer, camera, fov);
+
+		configuration.renderer->resetAccumulation();
+
+		float seconds = 0.0f;
+		size_t budget = 0;
+
+		while (budget < budgetsSeconds.size())
+		{
+			Clock::time_point start = Clock::now();
+
+			renderSample(configuration.renderer, camera, fov);
+
+			seconds += std::chrono::duration<float>(Clock::now() - start).count();
+
+			if (seconds < budgetsSeconds[budget]) continue;
+
+			Point point = { budgetsSeconds[budget], seconds, configuration.renderer->getSampleCount(), 0.0, 0.0 };
+
+			readImage(image);
+			computeErrors(image, reference, point.rmse, point.relMse);
+
+			// A slow sample may cross several budgets at once, they all share the same image.
+			while (budget < budgetsSeconds.size() && seconds >= budgetsSeconds[budget])
+			{
+				point.budgetSeconds = budgetsSeconds[budget++];
+
+				curves[i].push_back(point);
+			}
+		}
+
+		const Point& last = curves[i].back();
+
+		std::cout << "[INFO] CONVERGENCE BENCHMARK: " << getConfigurationName(configuration) << ": " << last.samples << " spp in " << last.seconds
+			<< " s, RMSE " << last.rmse << ", relMSE " << last.relMse << "." << std::endl;
+	}
+}
+
+bool ConvergenceBenchmark::checkBackends(Renderer* gpuRenderer, Renderer* cpuRenderer, Camera& camera, float fov, unsigned int samples, float tolerance)
+{
+	std::vector<glm::vec4> gpuImage(image.size());
+
+	Renderer* renderers[2] = { gpuRenderer, cpuRenderer };
+
+	for (int i = 0; i < 2; i++)
+	{
+		renderers[i]->setSortRays(false);
+		renderers[i]->setSampler(Sampler::SOBOL);
+		renderers[i]->setIndirectMode(Renderer::INDIRECT_PATHS);
+
+		for (unsigned int j = 0; j < samples; j++)
+		{
+			renderSample(renderers[i], camera, fov);
+		}
+
+		readImage(i == 0 ? gpuImage : image);
+	}
+
+	double relMse;
+
+	computeErrors(image, gpuImage, backendRmse, relMse);
+
+	backendSamples = samples;
+	backendsMatch = backendRmse <= tolerance;
+	backendsChecked = true;
+
+	std::cout << "[" << (backendsMatch ? "INFO" : "ERROR") << "] CONVERGENCE BENCHMARK: GPU and CPU images at " << samples << " spp differ by RMSE "
+		<< backendRmse << " (tolerance " << tolerance << ")." << std::endl;
+
+	return backendsMatch;
+}
+
+bool ConvergenceBenchmark::writeResults(const char* filepath)
+{
+	std::string path(filepath);
+
+	std::ofstream jsonStream(path + ".json");
+	std::ofstream csvStream(path + ".csv");
+
+	if (!jsonStream || !csvStream)
+	{
+		std::cout << "[ERROR] CONVERGENCE BENCHMARK: Failed to open \"" << path << ".json\" or \"" << path << ".csv\"." << std::endl;
+
+		return false;
+	}
+
+	jsonStream << "{\n";
+	jsonStream << "\t\"width\": " << width << ",\n";
+	jsonStream << "\t\"height\": " << height << ",\n";
+	jsonStream << "\t\"referenceSamples\": " << referenceSamples << ",\n";
+
+	if (backendsChecked)
+	{
+		jsonStream << "\t\"backendCheck\": { \"samples\": " << backendSamples << ", \"rmse\": " << backendRmse << ", \"passed\": " << (backendsMatch ? "true" : "false") << " },\n";
+	}
+
+	jsonStream << "\t\"configurations\": [\n";
+
+	csvStream << "configuration,backend,sampler,sorted_rays,indirect,budget_seconds,seconds,samples,rmse,relmse\n";
+
+	for (size_t i = 0; i < curves.size(); i++)
+	{
+		const Configuration& configuration = configurations[i];
+
+		std::string name = getConfigurationName(configuration);
+		std::string backend = configuration.renderer->getName();
+		std::string sampler = Sampler::getTypeName(configuration.sampler);
+		std::string sorted = configuration.sortRays ? "true" : "false";
+		std::string indirect = Renderer::getIndirectModeName(configuration.indirectMode);
+
+		jsonStream << "\t\t{\n";
+		jsonStream << "\t\t\t\"name\": \"" << name << "\",\n";
+		jsonStream << "\t\t\t\"backend\": \"" << backend << "\",\n";
+		jsonStream << "\t\t\t\"sampler\": \"" << sampler << "\",\n";
+		jsonStream << "\t\t\t\"sortedRays\": " << sorted << ",\n";
+		jsonStream << "\t\t\t\"indirect\": \"" << indirect << "\",\n";
+		jsonStream << "\t\t\t\"points\": [\n";
+
+		for (size_t j = 0; j < curves[i].size(); j++)
+		{
+			const Point& point = curves[i][j];
+
+			jsonStream << "\t\t\t\t{ \"budgetSeconds\": " << point.budgetSeconds << ", \"seconds\": " << point.seconds << ", \"samples\": " << point.samples
+				<< ", \"rmse\": " << point.rmse << ", \"relMse\": " << point.relMse << " }" << (j + 1 < curves[i].size() ? "," : "") << "\n";
+
+			csvStream << name << "," << backend << "," << sampler << "," << sorted << "," << indirect << "," << point.budgetSeconds << "," << point.seconds << ","
+				<< point.samples << "," << point.rmse << "," << point.relMse << "\n";
+		}
+
+		jsonStream << "\t\t\t]\n";
+		jsonStream << "\t\t}" << (i + 1 < curves.size() ? "," : "") << "\n";
+	}
+
+	jsonStream << "\t]\n";
+	jsonStream << "}\n";
+
+	if (!jsonStream || !csvStream)
+	{
+		std::cout << "[ERROR] CONVERGENCE BENCHMARK: Failed to write the results." << std::endl;
+
+		return false;
+	}
+
+	std::cout << "[INFO] CONVERGENCE BENCHMARK: Results written to \"" << path << ".json\" and \"" << path << ".csv\"." << std::endl;
+
+	return true;
+}
+
+unsigned long long ConvergenceBenchmark::computeKey(Camera& camera, float fov)
+{
+	// FNV-1a over everything the reference image depends on, apart from the texture files.
+	unsigned long long key = 14695981039346656037ull;
+
+	auto hashBytes = [&key](const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+
+		for (size_t i = 0; i < size; i++)
+		{
+			key = (key ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+
+	glm::mat4 viewMatrix = camera.getViewMatrix();
+
+	hashBytes(&viewMatrix, sizeof(viewMatrix));
+	hashBytes(&fov, sizeof(fov));
+	hashBytes(&scene.backgroundColor, sizeof(scene.backgroundColor));
+	hashBytes(scene.lights.data(), scene.lights.size() * sizeof(Light));
+	hashBytes(scene.materials.data(), scene.materials.size() * sizeof(Material));
+	hashBytes(scene.spheres.data(), scene.spheres.size() * sizeof(Sphere));
+	hashBytes(scene.planes.data(), scene.planes.size() * sizeof(Plane));
+	hashBytes(scene.triangles.data(), scene.triangles.size() * sizeof(Triangle));
+
+	return key;
+}
+
+void ConvergenceBenchmark::renderSample(Renderer* renderer, Camera& camera, float fov)
+{
+	renderer->render(camera, fov, outputTex);
+
+	glFinish();
+}
+
+void ConvergenceBenchmark::readImage(std::vector<glm::vec4>& pixels)
+{
+	outputTex->getImage(GL_RGBA, GL_FLOAT, (int)(pixels.size() * sizeof(glm::vec4)), pixels.data());
+}
+
+void ConvergenceBenchmark::computeErrors(const std::vector<glm::vec4>& pixels, const std::vector<glm::vec4>& target, double& rmse, double& relMse)
+{
+	double squaredSum = 0.0, relativeSum = 0.0;
+
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			double difference = (double)pixels[i][c] - (double)target[i][c];
+			double squared = difference * difference;
+
+			squaredSum += squared;
+			relativeSum += squared / ((double)target[i][c] * target[i][c] + 0.01);
+		}
+	}
+
+	double valueCount = 3.0 * pixels.size();
+
+	rmse = std::sqrt(squaredSum / valueCount);
+	relMse = relativeSum / valueCount;
+}
+
+std::string ConvergenceBenchmark::getConfigurationName(const Configuration& configuration)
+{
+	return std::string(configuration.renderer->getName()) + " / " + Sampler::getTypeName(configuration.sampler) + (configuration.sortRays ? " / sorted rays" : "")
+		+ " / " + Renderer::getIndirectModeName(configuration.indirectMode);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "renderer.h"
+#include "scene.h"
+#include "sampler.h"
+
+#include "../graphics/texture.h"
+#include "../utils/camera.h"
+
+// Equal-time convergence benchmark.
+//
+// A high sample count reference is rendered once with the reference backend (the CPU one), with path traced indirect
+// lighting so that it does not inherit the bias of the irradiance cache, and cached in a file,
+// which is only reused while its key matches: resolution, sample count, scene contents and view. Texture files are
+// not part of the key, the cached reference must be deleted after editing them.
+//
+// Every configuration then accumulates samples from scratch, with an empty irradiance cache, for the longest time
+// budget, and each time it crosses a budget the image is read back and compared with the reference. Read backs and
+// error computations are not counted against the budget. The GPU is synchronized after every sample, so that the
+// elapsed time covers the work done.
+//
+// Errors are measured over every RGB value:
+//
+//     RMSE   = sqrt(mean((image - reference)^2))
+//     relMSE = mean((image - reference)^2 / (reference^2 + 0.01))
+//
+// The curves are written as JSON and CSV. Finally, the GPU and CPU backends render the same number of samples with
+// the same sampler, which must give the same image up to floating point differences: the RMSE between the two is
+// reported as a regression check.
+//
+class ConvergenceBenchmark
+{
+public:
+	struct Configuration
+	{
+		Renderer* renderer;
+		Sampler::Type sampler;
+		bool sortRays;
+
+		Renderer::IndirectMode indirectMode;
+	};
+
+	struct Point
+	{
+		float budgetSeconds, seconds;
+		unsigned int samples;
+		double rmse, relMse;
+	};
+
+	ConvergenceBenchmark(const Scene& scene, int width, int height, Texture* outputTex);
+
+	void addConfiguration(Renderer* renderer, Sampler::Type sampler, bool sortRays, Renderer::IndirectMode indirectMode);
+
+	// Loads the cached reference if it matches, renders and caches it otherwise.
+	bool prepareReference(Renderer* referenceRenderer, Camera& camera, float fov, unsigned int samples, const char* filepath);
+
+	void run(Camera& camera, float fov, const std::vector<float>& budgetsSeconds);
+
+	// Returns false if the images of both backends differ by more than "tolerance" (RMSE).
+	bool checkBackends(Renderer* gpuRenderer, Renderer* cpuRenderer, Camera& camera, float fov, unsigned int samples, float tolerance);
+
+	// Writes "<filepath>.json" and "<filepath>.csv".
+	bool writeResults(const char* filepath);
+
+private:
+	struct ReferenceHeader
+	{
+		char magic[8];
+		unsigned int version;
+		unsigned int width, height, samples;
+		unsigned long long key;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	static const unsigned int REFERENCE_VERSION = 2;
+
+	const Scene& scene;
+	int width, height;
+	Texture* outputTex;
+
+	std::vector<glm::vec4> reference, image;
+	unsigned int referenceSamples;
+
+	std::vector<Configuration> configurations;
+	std::vector<std::vector<Point>> curves; // Indexed like "configurations".
+
+	unsigned int backendSamples;
+	double backendRmse;
+	bool backendsMatch, backendsChecked;
+
+	unsigned long long computeKey(Camera& camera, float fov);
+
+	void renderSample(Renderer* renderer, Camera& camera, float fov);
+	void readImage(std::vector<glm::vec4>& pixels);
+	void computeErrors(const std::vector<glm::vec4>& pixels, const std::vector<glm::vec4>& target, double& rmse, double& relMse);
+
+	static std::string getConfigurationName(const Configuration& configuration);
+};
@@ -0,0 +1,586 @@
+#include "cpu_renderer.h"
+
+CpuRenderer::CpuRenderer(const Scene& scene, Bvh* bvh, int width, int height, TextureLoader* textureLoader, ThreadPool* threadPool)
+	: scene(scene), bvh(bvh), width(width), height(height), lightCount((int)scene.lights.size()), globalThreshold(1e-3f),
+	  textureLoader(textureLoader), threadPool(threadPool), shadowRayCount(0)
+{
+	scene.computeBounds(sceneMin, sceneMax);
+
+	size_t pixelCount = (size_t)width * height;
+	size_t maxShadowRays = pixelCount * lightCount;
+
+	surfaces.resize(pixelCount);
+	shadowRays.resize(maxShadowRays);
+	sortKeys.resize(maxShadowRays);
+	sortValues.resize(maxShadowRays);
+	sortTempKeys.resize(maxShadowRays);
+	sortTempValues.resize(maxShadowRays);
+	visibility.resize(maxShadowRays);
+	indirect.resize(pixelCount);
+	accumulation.resize(pixelCount);
+	pixels.resize(pixelCount);
+}
+
+void CpuRenderer::render(Camera& camera, float fov, Texture* outputTex)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	beginSample(camera, fov, textureLoader->getLayerLods());
+
+	glm::vec3 viewPosition = camera.getPosition();
+	glm::mat3 inverseView = glm::inverse(glm::mat3(camera.getViewMatrix()));
+
+	Clock::time_point stageStart = Clock::now();
+
+	auto endStage = [&](Stage stage)
+	{
+		Clock::time_point now = Clock::now();
+
+		stageMilliseconds[stage] = std::chrono::duration<float, std::milli>(now - stageStart).count();
+		stageStart = now;
+	};
+
+	shadowRayCount = 0;
+
+	threadPool->parallelFor(height, 4, [&](int begin, int end) { tracePrimaryRays(begin, end, viewPosition, inverseView, fov); });
+
+	endStage(PRIMARY);
+
+	int rayCount = shadowRayCount;
+
+	if (sortRays)
+	{
+		radixSort(sortKeys.data(), sortValues.data(), sortTempKeys.data(), sortTempValues.data(), rayCount, SORT_KEY_BITS, threadPool);
+	}
+
+	endStage(SORT);
+
+	threadPool->parallelFor(rayCount, 4096, [this](int begin, int end) { traceShadowRays(begin, end); });
+
+	endStage(SHADOW);
+
+	irradianceCache.beginFrame(cacheFrame);
+
+	threadPool->parallelFor(height, 4, [&](int begin, int end) { traceIndirectRays(begin, end, viewPosition); });
+
+	if (indirectMode == INDIRECT_CACHED || cacheInvalidationPending)
+	{
+		irradianceCache.update(cacheInvalidationPending, cacheInvalidationMin, cacheInvalidationMax, threadPool);
+
+		cacheInvalidationPending = false;
+		cacheFrame += 1;
+	}
+
+	endStage(INDIRECT);
+
+	threadPool->parallelFor(height, 16, [this](int begin, int end) { resolvePixels(begin, end); });
+
+	outputTex->setImage(width, height, GL_RGBA, GL_FLOAT, pixels.data());
+
+	endStage(RESOLVE);
+
+	endSample();
+}
+
+const char* CpuRenderer::getName()
+{
+	return "CPU";
+}
+
+void CpuRenderer::updateScene(const Scene& scene, Bvh* bvh, const glm::vec3& changedMin, const glm::vec3& changedMax)
+{
+	this->scene = scene;
+	this->bvh = bvh;
+
+	scene.computeBounds(sceneMin, sceneMax);
+
+	invalidateCache(changedMin, changedMax);
+}
+
+void CpuRenderer::clearCache()
+{
+	irradianceCache.clear();
+
+	cacheFrame = 0;
+	cacheInvalidationPending = false;
+
+	resetAccumulation();
+}
+
+float CpuRenderer::raySphereIntersect(const glm::vec3& origin, const glm::vec3& direction, const Sphere& sphere)
+{
+	glm::vec3 xa = origin - sphere.center;
+	float b = glm::dot(xa, direction);
+
+	glm::vec3 closestOffset = xa - (direction * b);
+	float delta = (sphere.radius * sphere.radius) - glm::dot(closestOffset, closestOffset);
+
+	if (delta < 0.0f) return -1.0f;
+
+	float s1 = -b - std::sqrt(delta);
+	float s2 = -b + std::sqrt(delta);
+
+	if (s1 > 0.0f) return s1;
+	else if (s2 > 0.0f) return s2;
+
+	return -1.0f;
+}
+
+float CpuRenderer::rayPlaneIntersect(const glm::vec3& origin, const glm::vec3& direction, const Plane& plane)
+{
+	if (std::abs(direction.y) <= globalThreshold) return -1.0f;
+
+	float planeDistance = (plane.yPosition - origin.y) / direction.y;
+	glm::vec3 point = origin + (direction * planeDistance);
+
+	if (std::abs(point.x) < plane.xSize && std::abs(point.z) < plane.zSize) return planeDistance;
+
+	return -1.0f;
+}
+
+float CpuRenderer::rayTriangleIntersect(const glm::vec3& origin, const glm::vec3& direction, const Triangle& triangle, glm::vec2& barycentrics)
+{
+	glm::vec3 edge1 = triangle.vertex1 - triangle.vertex0;
+	glm::vec3 edge2 = triangle.vertex2 - triangle.vertex0;
+	glm::vec3 p = glm::cross(direction, edge2);
+
+	float determinant = glm::dot(edge1, p);
+
+	barycentrics = glm::vec2(0.0f);
+
+	if (determinant == 0.0f) return -1.0f;
+
+	float inverseDeterminant = 1.0f / determinant;
+
+	glm::vec3 offset = origin - triangle.vertex0;
+	float u = glm::dot(offset, p) * inverseDeterminant;
+
+	if (u < 0.0f || u > 1.0f) return -1.0f;
+
+	glm::vec3 q = glm::cross(offset, edge1);
+	float v = glm::dot(direction, q) * inverseDeterminant;
+
+	if (v < 0.0f || u + v > 1.0f) return -1.0f;
+
+	barycentrics = glm::vec2(u, v);
+
+	return glm::dot(edge2, q) * inverseDeterminant;
+}
+
+float CpuRenderer::primitiveIntersect(unsigned int primitive, const glm::vec3& origin, const glm::vec3& direction)
+{
+	unsigned int index = primitive & PRIMITIVE_INDEX_MASK;
+	unsigned int type = primitive >> PRIMITIVE_TYPE_SHIFT;
+
+	if (type == PRIMITIVE_SPHERE) return raySphereIntersect(origin, direction, scene.spheres[index]);
+	if (type == PRIMITIVE_PLANE) return rayPlaneIntersect(origin, direction, scene.planes[index]);
+
+	glm::vec2 barycentrics;
+
+	return rayTriangleIntersect(origin, direction, scene.triangles[index], barycentrics);
+}
+
+CpuRenderer::Hit CpuRenderer::sceneIntersect(const glm::vec3& origin, const glm::vec3& direction)
+{
+	const float pi = 3.14159265359f;
+
+	Hit hitInfo;
+
+	hitInfo.performed = false;
+
+	float closestDistance = 1e32f;
+	unsigned int closestPrimitive = 0;
+
+	bvh->traverseWide(origin, direction, closestDistance, [&](unsigned int primitive, float& maxDistance)
+	{
+		float distance = primitiveIntersect(primitive, origin, direction);
+
+		if (distance > 0.0f && distance < maxDistance)
+		{
+			maxDistance = distance;
+			closestDistance = distance;
+			closestPrimitive = primitive;
+			hitInfo.performed = true;
+		}
+
+		return false;
+	});
+
+	if (!hitInfo.performed) return hitInfo;
+
+	unsigned int index = closestPrimitive & PRIMITIVE_INDEX_MASK;
+	unsigned int type = closestPrimitive >> PRIMITIVE_TYPE_SHIFT;
+
+	hitInfo.point = origin + (direction * closestDistance);
+
+	if (type == PRIMITIVE_SPHERE)
+	{
+		const Sphere& sphere = scene.spheres[index];
+
+		hitInfo.normal = glm::normalize(hitInfo.point - sphere.center);
+		hitInfo.uv = glm::vec2(0.5f + std::atan2(hitInfo.normal.z, hitInfo.normal.x) / (2.0f * pi), 0.5f + std::asin(hitInfo.normal.y) / pi);
+		hitInfo.material = sphere.material;
+	}
+	else if (type == PRIMITIVE_PLANE)
+	{
+		const Plane& plane = scene.planes[index];
+
+		hitInfo.normal = plane.normal;
+		hitInfo.uv = glm::vec2(hitInfo.point.x, hitInfo.point.z) * 0.25f;
+		hitInfo.material = plane.material;
+	}
+	else
+	{
+		const Triangle& triangle = scene.triangles[index];
+
+		rayTriangleIntersect(origin, direction, triangle, hitInfo.uv);
+
+		hitInfo.normal = glm::normalize(glm::cross(triangle.vertex1 - triangle.vertex0, triangle.vertex2 - triangle.vertex0));
+		hitInfo.normal = glm::dot(hitInfo.normal, direction) > 0.0f ? -hitInfo.normal : hitInfo.normal;
+		hitInfo.material = triangle.material;
+	}
+
+	return hitInfo;
+}
+
+bool CpuRenderer::sceneOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+{
+	bool occluded = false;
+
+	bvh->traverseWide(origin, direction, maxDistance, [&](unsigned int primitive, float& limit)
+	{
+		float distance = primitiveIntersect(primitive, origin, direction);
+
+		occluded = distance > 0.0f && distance < limit;
+
+		return occluded;
+	});
+
+	return occluded;
+}
+
+glm::vec2 CpuRenderer::concentricDisk(const glm::vec2& u)
+{
+	// Mirror of "concentric_disk()" in "shaders/common/scene.glsl".
+	const float pi = 3.14159265359f;
+
+	glm::vec2 offset = 2.0f * u - 1.0f;
+
+	if (offset.x == 0.0f && offset.y == 0.0f) return glm::vec2(0.0f);
+
+	bool horizontal = std::abs(offset.x) > std::abs(offset.y);
+
+	float radius = horizontal ? offset.x : offset.y;
+	float theta = horizontal ? (pi / 4.0f) * (offset.y / offset.x) : (pi / 2.0f) - (pi / 4.0f) * (offset.x / offset.y);
+
+	return radius * glm::vec2(std::cos(theta), std::sin(theta));
+}
+
+void CpuRenderer::orthonormalBasis(const glm::vec3& w, glm::vec3& tangent, glm::vec3& bitangent)
+{
+	float s = w.z >= 0.0f ? 1.0f : -1.0f;
+	float a = -1.0f / (s + w.z);
+	float b = w.x * w.y * a;
+
+	tangent = glm::vec3(1.0f + s * w.x * w.x * a, s * b, -s * w.x);
+	bitangent = glm::vec3(b, s + w.y * w.y * a, -w.y);
+}
+
+glm::vec3 CpuRenderer::lightSamplePoint(const Light& light, const glm::vec3& point, const glm::vec2& u)
+{
+	// Mirror of "light_sample_point()" in "shaders/common/scene.glsl".
+	glm::vec2 disk = concentricDisk(u);
+
+	glm::vec3 tangent, bitangent;
+
+	orthonormalBasis(glm::normalize(light.position - point), tangent, bitangent);
+
+	return light.position + light.radius * (disk.x * tangent + disk.y * bitangent);
+}
+
+glm::vec3 CpuRenderer::cosineSampleHemisphere(const glm::vec3& normal, const glm::vec2& u)
+{
+	// Mirror of "cosine_sample_hemisphere()" in "shaders/common/scene.glsl".
+	glm::vec2 disk = concentricDisk(u);
+
+	glm::vec3 tangent, bitangent;
+
+	orthonormalBasis(normal, tangent, bitangent);
+
+	return glm::normalize(disk.x * tangent + disk.y * bitangent + std::sqrt(std::max(1.0f - glm::dot(disk, disk), 0.0f)) * normal);
+}
+
+glm::vec3 CpuRenderer::directLighting(const glm::vec3& point, const glm::vec3& normal, int px, int py, unsigned int firstDimension)
+{
+	// Mirror of "direct_lighting()" in "shaders/trace_indirect_rays_cs.glsl".
+	glm::vec3 lightDiffuseComp(1.0f, 1.0f, 1.0f);
+	float lightDiffuseFactor = 0.0f;
+
+	for (int i = 0; i < lightCount; i++)
+	{
+		glm::vec2 u(Sampler::get(sampler, (unsigned int)px, (unsigned int)py, sampleIndex, firstDimension + 2 * i),
+			Sampler::get(sampler, (unsigned int)px, (unsigned int)py, sampleIndex, firstDimension + 1 + 2 * i));
+		glm::vec3 lightPoint = lightSamplePoint(scene.lights[i], point, u);
+
+		glm::vec3 lightDirection = glm::normalize(lightPoint - point);
+		glm::vec3 newOrigin = glm::dot(lightDirection, normal) < 0.0f ? point - (normal * globalThreshold) : point + (normal * globalThreshold);
+
+		if (sceneOccluded(newOrigin, lightDirection, glm::length(lightPoint - newOrigin))) continue;
+
+		lightDirection = glm::normalize(scene.lights[i].position - point);
+
+		lightDiffuseComp *= scene.lights[i].color;
+		lightDiffuseFactor += scene.lights[i].intensity * glm::clamp(glm::dot(lightDirection, normal), 0.0f, 1.0f);
+	}
+
+	return lightDiffuseComp * lightDiffuseFactor;
+}
+
+glm::vec3 CpuRenderer::materialAlbedo(unsigned int materialIndex, const glm::vec2& uv)
+{
+	const Material& material = scene.materials[materialIndex];
+	const std::vector<float>& textureLods = textureLoader->getLayerLods();
+
+	if (material.textureLayer < 0 || material.textureLayer >= (int)textureLods.size() || textureLods[material.textureLayer] < 0.0f)
+	{
+		return material.diffuseColor;
+	}
+
+	// Bilinear filtering with repeat wrapping of the same level the compute shader samples.
+	int levelWidth, levelHeight;
+	const unsigned char* texels = textureLoader->getLevelPixels(material.textureLayer, (int)textureLods[material.textureLayer], levelWidth, levelHeight);
+
+	float x = uv.x * levelWidth - 0.5f;
+	float y = uv.y * levelHeight - 0.5f;
+	float x0 = std::floor(x), y0 = std::floor(y);
+	float fx = x - x0, fy = y - y0;
+
+	auto texel = [&](int i, int j)
+	{
+		i = ((i % levelWidth) + levelWidth) % levelWidth;
+		j = ((j % levelHeight) + levelHeight) % levelHeight;
+
+		const unsigned char* t = texels + ((size_t)j * levelWidth + i) * 4;
+
+		return glm::vec3(t[0], t[1], t[2]) / 255.0f;
+	};
+
+	int i0 = (int)x0, j0 = (int)y0;
+
+	return glm::mix(glm::mix(texel(i0, j0), texel(i0 + 1, j0), fx), glm::mix(texel(i0, j0 + 1), texel(i0 + 1, j0 + 1), fx), fy);
+}
+
+unsigned int CpuRenderer::rayKey(const glm::vec3& origin, const glm::vec3& direction)
+{
+	// Mirror of "ray_sort_key()" in "shaders/common/wavefront.glsl".
+	glm::vec3 o = glm::clamp((origin - sceneMin) / glm::max(sceneMax - sceneMin, glm::vec3(1e-6f)), 0.0f, 1.0f);
+
+	glm::vec3 d = direction / (std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+	glm::vec2 octahedral = d.z >= 0.0f ? glm::vec2(d.x, d.y) : (1.0f - glm::abs(glm::vec2(d.y, d.x))) * glm::vec2(d.x >= 0.0f ? 1.0f : -1.0f, d.y >= 0.0f ? 1.0f : -1.0f);
+	glm::vec2 od = glm::clamp(octahedral * 0.5f + 0.5f, 0.0f, 1.0f);
+
+	glm::uvec3 originBits = glm::uvec3(o * 63.0f + 0.5f);
+	glm::uvec2 directionBits = glm::uvec2(od * 63.0f + 0.5f);
+
+	unsigned int key = 0;
+
+	for (int bit = 5; bit >= 0; bit--)
+	{
+		key = (key << 5) | (((directionBits.x >> bit) & 1u) << 4) | (((directionBits.y >> bit) & 1u) << 3)
+			| (((originBits.x >> bit) & 1u) << 2) | (((originBits.y >> bit) & 1u) << 1) | ((originBits.z >> bit) & 1u);
+	}
+
+	return key;
+}
+
+void CpuRenderer::tracePrimaryRays(int begin, int end, const glm::vec3& viewPosition, const glm::mat3& inverseView, float fov)
+{
+	std::vector<ShadowRay> chunkRays; // Rays of this chunk, appended to the queue with a single atomic operation.
+
+	float tanHalfFov = std::tan(glm::radians(fov) / 2.0f);
+
+	for (int py = begin; py < end; py++)
+	{
+		for (int px = 0; px < width; px++)
+		{
+			unsigned int pixel = (unsigned int)(py * width + px);
+
+			auto sample = [&](unsigned int dimension) { return Sampler::get(sampler, (unsigned int)px, (unsigned int)py, sampleIndex, dimension); };
+
+			float x = (2.0f * (px + sample(0)) / width - 1.0f) * tanHalfFov * width / height;
+			float y = (2.0f * (py + sample(1)) / height - 1.0f) * tanHalfFov;
+
+			glm::vec3 viewDirection = inverseView * glm::normalize(glm::vec3(x, y, -1.0f));
+
+			Hit hitInfo = sceneIntersect(viewPosition, viewDirection);
+			Surface& surface = surfaces[pixel];
+
+			surface.performed = hitInfo.performed;
+
+			if (!hitInfo.performed) continue;
+
+			surface.point = hitInfo.point;
+			surface.normal = hitInfo.normal;
+			surface.albedo = materialAlbedo(hitInfo.material, hitInfo.uv);
+
+			for (int i = 0; i < lightCount; i++)
+			{
+				glm::vec3 lightPoint = lightSamplePoint(scene.lights[i], hitInfo.point, glm::vec2(sample(2 + 2 * i), sample(3 + 2 * i)));
+
+				glm::vec3 lightDirection = glm::normalize(lightPoint - hitInfo.point);
+				glm::vec3 newOrigin = glm::dot(lightDirection, hitInfo.normal) < 0.0f ? hitInfo.point - (hitInfo.normal * globalThreshold) : hitInfo.point + (hitInfo.normal * globalThreshold);
+
+				chunkRays.push_back({ newOrigin, pixel * lightCount + i, lightDirection, glm::length(lightPoint - newOrigin) });
+			}
+		}
+	}
+
+	int firstRay = shadowRayCount.fetch_add((int)chunkRays.size());
+
+	for (int i = 0; i < (int)chunkRays.size(); i++)
+	{
+		shadowRays[firstRay + i] = chunkRays[i];
+		visibility[chunkRays[i].slot] = 0;
+
+		sortKeys[firstRay + i] = sortRays ? rayKey(chunkRays[i].origin, chunkRays[i].direction) : 0u;
+		sortValues[firstRay + i] = firstRay + i;
+	}
+}
+
+void CpuRenderer::traceShadowRays(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const ShadowRay& ray = shadowRays[sortValues[i]];
+
+		visibility[ray.slot] = sceneOccluded(ray.origin, ray.direction, ray.maxDistance) ? 0 : 1;
+	}
+}
+
+void CpuRenderer::traceIndirectRays(int begin, int end, const glm::vec3& viewPosition)
+{
+	// Mirror of "shaders/trace_indirect_rays_cs.glsl".
+	glm::vec3 albedos[INDIRECT_BOUNCES + 1];
+	glm::vec3 direct[INDIRECT_BOUNCES + 1];
+	unsigned int cacheSlots[INDIRECT_BOUNCES + 1];
+
+	unsigned int dimensionsPerBounce = 2 + 2 * lightCount;
+
+	for (int py = begin; py < end; py++)
+	{
+		for (int px = 0; px < width; px++)
+		{
+			unsigned int pixel = (unsigned int)(py * width + px);
+			const Surface& surface = surfaces[pixel];
+
+			indirect[pixel] = glm::vec3(0.0f);
+
+			if (!surface.performed || indirectMode == INDIRECT_OFF) continue;
+
+			glm::vec3 point = surface.point;
+			glm::vec3 normal = glm::dot(surface.normal, surface.point - viewPosition) > 0.0f ? -surface.normal : surface.normal;
+
+			glm::vec3 cachedIrradiance(0.0f);
+			bool cached = false;
+
+			if (indirectMode == INDIRECT_CACHED)
+			{
+				glm::vec2 u = IrradianceCache::getJitter(pixel, sampleIndex);
+				glm::vec3 tangent, bitangent;
+
+				orthonormalBasis(normal, tangent, bitangent);
+
+				float cellSize = IrradianceCache::getCellSize(point, viewPosition);
+				glm::vec3 lookupPoint = point + cellSize * ((u.x - 0.5f) * tangent + (u.y - 0.5f) * bitangent);
+
+				cached = irradianceCache.query(lookupPoint, normal, viewPosition, cachedIrradiance);
+
+				if (cached && !irradianceCache.isTrainingPixel(pixel))
+				{
+					indirect[pixel] = cachedIrradiance;
+
+					continue;
+				}
+			}
+
+			cacheSlots[0] = indirectMode == INDIRECT_CACHED ? irradianceCache.find(point, normal, viewPosition, true) : IrradianceCache::NOT_FOUND;
+
+			glm::vec3 irradiance(0.0f); // Arriving at the last vertex, from the cache or nothing.
+			int vertexCount = 1;
+
+			for (int bounce = 0; bounce < INDIRECT_BOUNCES; bounce++)
+			{
+				unsigned int dimension = dimensionsPerBounce * (bounce + 1);
+
+				glm::vec2 u(Sampler::get(sampler, (unsigned int)px, (unsigned int)py, sampleIndex, dimension), Sampler::get(sampler, (unsigned int)px, (unsigned int)py, sampleIndex, dimension + 1));
+				glm::vec3 direction = cosineSampleHemisphere(normal, u);
+
+				Hit hitInfo = sceneIntersect(point + (normal * globalThreshold), direction);
+
+				if (!hitInfo.performed) break; // The background is a backdrop, not a light.
+
+				point = hitInfo.point;
+				normal = glm::dot(hitInfo.normal, direction) > 0.0f ? -hitInfo.normal : hitInfo.normal;
+
+				albedos[vertexCount] = materialAlbedo(hitInfo.material, hitInfo.uv);
+				direct[vertexCount] = directLighting(point, normal, px, py, dimension + 2);
+				cacheSlots[vertexCount] = IrradianceCache::NOT_FOUND;
+
+				vertexCount++;
+
+				if (indirectMode == INDIRECT_CACHED)
+				{
+					if (irradianceCache.query(point, normal, viewPosition, irradiance)) break;
+
+					if (bounce + 1 < INDIRECT_BOUNCES) cacheSlots[vertexCount - 1] = irradianceCache.find(point, normal, viewPosition, true);
+				}
+			}
+
+			for (int i = vertexCount - 1; i > 0; i--)
+			{
+				if (cacheSlots[i] != IrradianceCache::NOT_FOUND) irradianceCache.addSample(cacheSlots[i], irradiance);
+
+				irradiance = albedos[i] * (direct[i] + irradiance);
+			}
+
+			if (cacheSlots[0] != IrradianceCache::NOT_FOUND) irradianceCache.addSample(cacheSlots[0], irradiance);
+
+			indirect[pixel] = cached ? cachedIrradiance : irradiance;
+		}
+	}
+}
+
+void CpuRenderer::resolvePixels(int begin, int end)
+{
+	for (int py = begin; py < end; py++)
+	{
+		for (int px = 0; px < width; px++)
+		{
+			unsigned int pixel = (unsigned int)(py * width + px);
+			const Surface& surface = surfaces[pixel];
+
+			glm::vec3 color = scene.backgroundColor;
+
+			if (surface.performed)
+			{
+				glm::vec3 lightDiffuseComp(1.0f, 1.0f, 1.0f);
+				float lightDiffuseFactor = 0.0f;
+
+				for (int i = 0; i < lightCount; i++)
+				{
+					if (!visibility[pixel * lightCount + i]) continue; // Occluded, as found by the shadow pass.
+
+					glm::vec3 lightDirection = glm::normalize(scene.lights[i].position - surface.point);
+
+					lightDiffuseComp *= scene.lights[i].color;
+					lightDiffuseFactor += scene.lights[i].intensity * glm::clamp(glm::dot(lightDirection, surface.normal), 0.0f, 1.0f);
+				}
+
+				color = surface.albedo * (lightDiffuseComp * lightDiffuseFactor + indirect[pixel]);
+			}
+
+			accumulation[pixel] = sampleIndex == 0 ? glm::vec4(color, 1.0f) : accumulation[pixel] + glm::vec4(color, 1.0f);
+			pixels[pixel] = accumulation[pixel] / (float)(sampleIndex + 1);
+		}
+	}
+}
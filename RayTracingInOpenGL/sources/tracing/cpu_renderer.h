@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <random>
+
+#include <glad/glad.h>
+
+#include "renderer.h"
+#include "scene.h"
+#include "bvh.h"
+#include "sampler.h"
+#include "irradiance_cache.h"
+
+#include "../graphics/texture_loader.h"
+#include "../utils/thread_pool.h"
+#include "../utils/radix_sort.h"
+
+// CPU port of the wavefront pipeline of "GpuRenderer", running every stage on the thread pool. It traces the same
+// scene with the same routines as the compute shaders, and sorts its shadow rays with the same keys.
+//
+class CpuRenderer : public Renderer
+{
+public:
+	CpuRenderer(const Scene& scene, Bvh* bvh, int width, int height, TextureLoader* textureLoader, ThreadPool* threadPool);
+
+	void render(Camera& camera, float fov, Texture* outputTex) override;
+	const char* getName() override;
+
+	void updateScene(const Scene& scene, Bvh* bvh, const glm::vec3& changedMin, const glm::vec3& changedMax) override;
+	void clearCache() override;
+
+private:
+	struct Hit
+	{
+		glm::vec3 point;
+		glm::vec3 normal;
+		glm::vec2 uv;
+
+		unsigned int material;
+
+		bool performed;
+	};
+
+	struct Surface
+	{
+		glm::vec3 point;
+		glm::vec3 normal;
+		glm::vec3 albedo;
+
+		bool performed;
+	};
+
+	struct ShadowRay
+	{
+		glm::vec3 origin;
+
+		unsigned int slot; // Pixel index * lightCount + light index.
+
+		glm::vec3 direction;
+
+		float maxDistance;
+	};
+
+	static const int SORT_KEY_BITS = 30;
+
+	Scene scene;
+
+	Bvh* bvh;
+
+	int width, height, lightCount;
+	float globalThreshold;
+
+	glm::vec3 sceneMin, sceneMax;
+
+	TextureLoader* textureLoader;
+	ThreadPool* threadPool;
+
+	std::vector<Surface> surfaces;
+	std::vector<ShadowRay> shadowRays;
+	std::vector<unsigned int> sortKeys, sortValues, sortTempKeys, sortTempValues;
+	std::vector<unsigned char> visibility;
+	std::vector<glm::vec3> indirect;
+	std::vector<glm::vec4> accumulation, pixels;
+
+	IrradianceCache irradianceCache;
+
+	std::atomic<int> shadowRayCount;
+
+	float raySphereIntersect(const glm::vec3& origin, const glm::vec3& direction, const Sphere& sphere);
+	float rayPlaneIntersect(const glm::vec3& origin, const glm::vec3& direction, const Plane& plane);
+	float rayTriangleIntersect(const glm::vec3& origin, const glm::vec3& direction, const Triangle& triangle, glm::vec2& barycentrics);
+	float primitiveIntersect(unsigned int primitive, const glm::vec3& origin, const glm::vec3& direction);
+
+	Hit sceneIntersect(const glm::vec3& origin, const glm::vec3& direction);
+	bool sceneOccluded(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+	glm::vec2 concentricDisk(const glm::vec2& u);
+	void orthonormalBasis(const glm::vec3& w, glm::vec3& tangent, glm::vec3& bitangent);
+	glm::vec3 lightSamplePoint(const Light& light, const glm::vec3& point, const glm::vec2& u);
+	glm::vec3 cosineSampleHemisphere(const glm::vec3& normal, const glm::vec2& u);
+	glm::vec3 directLighting(const glm::vec3& point, const glm::vec3& normal, int px, int py, unsigned int firstDimension);
+	glm::vec3 materialAlbedo(unsigned int materialIndex, const glm::vec2& uv);
+	unsigned int rayKey(const glm::vec3& origin, const glm::vec3& direction);
+
+	void tracePrimaryRays(int begin, int end, const glm::vec3& viewPosition, const glm::mat3& inverseView, float fov);
+	void traceShadowRays(int begin, int end);
+	void traceIndirectRays(int begin, int end, const glm::vec3& viewPosition);
+	void resolvePixels(int begin, int end);
+};
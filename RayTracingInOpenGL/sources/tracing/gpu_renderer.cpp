@@ -0,0 +1,316 @@
+#include "gpu_renderer.h"
+
+template <typename T>
+static SSBO* createSceneSSBO(const std::vector<T>& items, const SceneFileSections::Section* mapped = NULL)
+{
+	// A mapped scene file section holds the same elements, uploading it skips reading the copy back.
+	if (mapped && mapped->data && mapped->size > 0) return new SSBO(mapped->data, mapped->size, GL_STATIC_DRAW);
+
+	// Empty arrays still get a small buffer, so that every binding point stays valid.
+	long long size = (long long)(items.size() * sizeof(T));
+
+	return new SSBO(items.empty() ? NULL : items.data(), size > 0 ? size : 16, GL_STATIC_DRAW);
+}
+
+GpuRenderer::GpuRenderer(const Scene& scene, Bvh* bvh, int width, int height, TextureLoader* textureLoader, const SceneFileSections* sections)
+	: width(width), height(height), lightCount((int)scene.lights.size()), textureLoader(textureLoader)
+{
+	tracePrimaryRaysSP = new ShaderProgram("sources/shaders/trace_primary_rays_cs.glsl");
+	prepareShadowRaysSP = new ShaderProgram("sources/shaders/prepare_shadow_rays_cs.glsl");
+	radixSortHistogramSP = new ShaderProgram("sources/shaders/radix_sort_histogram_cs.glsl");
+	radixSortScanSP = new ShaderProgram("sources/shaders/radix_sort_scan_cs.glsl");
+	radixSortScatterSP = new ShaderProgram("sources/shaders/radix_sort_scatter_cs.glsl");
+	traceShadowRaysSP = new ShaderProgram("sources/shaders/trace_shadow_rays_cs.glsl");
+	traceIndirectRaysSP = new ShaderProgram("sources/shaders/trace_indirect_rays_cs.glsl");
+	updateIrradianceCacheSP = new ShaderProgram("sources/shaders/update_irradiance_cache_cs.glsl");
+	renderOutputTexSP = new ShaderProgram("sources/shaders/render_output_tex_rt_cs.glsl");
+
+	uploadScene(scene, bvh, sections);
+
+	long long pixelCount = (long long)width * height;
+	long long maxShadowRays = pixelCount * std::max(lightCount, 1);
+	long long maxSortGroups = (maxShadowRays + SORT_GROUP_SIZE - 1) / SORT_GROUP_SIZE;
+
+	surfacesSSBO = new SSBO(NULL, pixelCount * 48);
+	shadowRaysSSBO = new SSBO(NULL, SHADOW_RAYS_HEADER_SIZE + maxShadowRays * 32);
+	sortPairsSSBOs[0] = new SSBO(NULL, maxShadowRays * 8);
+	sortPairsSSBOs[1] = new SSBO(NULL, maxShadowRays * 8);
+	sortHistogramSSBO = new SSBO(NULL, maxSortGroups * 16 * 4);
+	visibilitySSBO = new SSBO(NULL, maxShadowRays * 4); // One slot per pixel and light, like the CPU backend.
+	blueNoiseSSBO = createSceneSSBO(Sampler::getBlueNoiseMask());
+	accumulationSSBO = new SSBO(NULL, pixelCount * 16);
+	indirectSSBO = new SSBO(NULL, pixelCount * 16);
+	cacheCellsSSBO = new SSBO(NULL, (long long)IrradianceCache::CAPACITY * IrradianceCache::CELL_SIZE);
+	cacheAccumulatorsSSBO = new SSBO(NULL, (long long)IrradianceCache::CAPACITY * IrradianceCache::ACCUMULATOR_SIZE);
+
+	// Free slots and empty accumulators are all zeros.
+	cacheCellsSSBO->clear();
+	cacheAccumulatorsSSBO->clear();
+
+	for (int i = 0; i < STAGE_COUNT; i++)
+	{
+		stageTimers[i] = new GpuTimer();
+	}
+
+	tracePrimaryRaysSP->bind();
+	tracePrimaryRaysSP->setUniform2i("u_image_size", width, height);
+
+	traceIndirectRaysSP->bind();
+	traceIndirectRaysSP->setUniform2i("u_image_size", width, height);
+	traceIndirectRaysSP->setUniform1i("u_indirect_bounces", INDIRECT_BOUNCES);
+
+	updateIrradianceCacheSP->bind();
+	updateIrradianceCacheSP->setUniform1ui("u_cache_max_samples", IrradianceCache::MAX_SAMPLES);
+	updateIrradianceCacheSP->setUniform1ui("u_cache_max_age", IrradianceCache::MAX_AGE);
+	updateIrradianceCacheSP->unbind();
+}
+
+GpuRenderer::~GpuRenderer()
+{
+	delete tracePrimaryRaysSP;
+	delete prepareShadowRaysSP;
+	delete radixSortHistogramSP;
+	delete radixSortScanSP;
+	delete radixSortScatterSP;
+	delete traceShadowRaysSP;
+	delete traceIndirectRaysSP;
+	delete updateIrradianceCacheSP;
+	delete renderOutputTexSP;
+
+	deleteScene();
+
+	delete surfacesSSBO;
+	delete shadowRaysSSBO;
+	delete sortPairsSSBOs[0];
+	delete sortPairsSSBOs[1];
+	delete sortHistogramSSBO;
+	delete visibilitySSBO;
+	delete blueNoiseSSBO;
+	delete accumulationSSBO;
+	delete indirectSSBO;
+	delete cacheCellsSSBO;
+	delete cacheAccumulatorsSSBO;
+
+	for (int i = 0; i < STAGE_COUNT; i++)
+	{
+		delete stageTimers[i];
+	}
+}
+
+void GpuRenderer::render(Camera& camera, float fov, Texture* outputTex)
+{
+	const std::vector<float>& textureLods = textureLoader->getLayerLods();
+	const int textureLayerCount = std::min((int)textureLods.size(), MAX_TEXTURE_LAYERS);
+	const unsigned int zero = 0;
+
+	beginSample(camera, fov, textureLods);
+
+	lightsSSBO->bind(LIGHTS);
+	materialsSSBO->bind(MATERIALS);
+	spheresSSBO->bind(SPHERES);
+	planesSSBO->bind(PLANES);
+	trianglesSSBO->bind(TRIANGLES);
+	bvhNodesSSBO->bind(BVH_NODES);
+	bvhPrimitivesSSBO->bind(BVH_PRIMITIVES);
+	surfacesSSBO->bind(SURFACES);
+	shadowRaysSSBO->bind(SHADOW_RAYS);
+	sortPairsSSBOs[0]->bind(SORT_PAIRS);
+	sortHistogramSSBO->bind(SORT_HISTOGRAM);
+	visibilitySSBO->bind(VISIBILITY);
+	blueNoiseSSBO->bind(BLUE_NOISE);
+	accumulationSSBO->bind(ACCUMULATION);
+	indirectSSBO->bind(INDIRECT_IRRADIANCE);
+	cacheCellsSSBO->bind(CACHE_CELLS);
+	cacheAccumulatorsSSBO->bind(CACHE_ACCUMULATORS);
+
+	shadowRaysSSBO->setData(&zero, sizeof(zero)); // Reset the ray counter.
+	shadowRaysSSBO->bindIndirect();
+
+	// Primary rays, then size the per ray dispatches to the number of shadow rays emitted.
+	stageTimers[PRIMARY]->begin();
+
+	tracePrimaryRaysSP->bind();
+	tracePrimaryRaysSP->setUniform3f("u_view_position", camera.getPosition());
+	tracePrimaryRaysSP->setUniformMatrix4fv("u_view_matrix", camera.getViewMatrix());
+	tracePrimaryRaysSP->setUniform1f("u_fov", glm::radians(fov));
+	tracePrimaryRaysSP->setUniform1i("u_sort_rays", sortRays);
+	tracePrimaryRaysSP->setUniform1i("u_sampler", sampler);
+	tracePrimaryRaysSP->setUniform1ui("u_sample_index", sampleIndex);
+	tracePrimaryRaysSP->setUniform1fv("u_texture_lods", textureLayerCount, textureLods.data());
+	tracePrimaryRaysSP->setUniform1i("u_texture_layer_count", textureLayerCount);
+
+	glDispatchCompute((unsigned int)(width + 7) / 8, (unsigned int)(height + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	prepareShadowRaysSP->bind();
+
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+	stageTimers[PRIMARY]->end();
+
+	// Radix sort of the (key, ray index) pairs, 4 bits per pass, ping-ponging between the two pair buffers.
+	stageTimers[SORT]->begin();
+
+	if (sortRays)
+	{
+		for (int shift = 0, source = 0; shift < SORT_KEY_BITS; shift += 4, source = 1 - source)
+		{
+			sortPairsSSBOs[source]->bind(SORT_PAIRS);
+			sortPairsSSBOs[1 - source]->bind(SORT_PAIRS_OUT);
+
+			radixSortHistogramSP->bind();
+			radixSortHistogramSP->setUniform1ui("u_shift", (unsigned int)shift);
+
+			glDispatchComputeIndirect(SHADOW_RAY_GROUPS_OFFSET);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+			radixSortScanSP->bind();
+
+			glDispatchCompute(1, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+			radixSortScatterSP->bind();
+			radixSortScatterSP->setUniform1ui("u_shift", (unsigned int)shift);
+
+			glDispatchComputeIndirect(SHADOW_RAY_GROUPS_OFFSET);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+
+		sortPairsSSBOs[0]->bind(SORT_PAIRS); // An even number of passes leaves the sorted pairs in the first buffer.
+	}
+
+	stageTimers[SORT]->end();
+
+	stageTimers[SHADOW]->begin();
+
+	traceShadowRaysSP->bind();
+
+	glDispatchComputeIndirect(SHADOW_RAY_GROUPS_OFFSET);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	stageTimers[SHADOW]->end();
+
+	// Indirect paths, then the cache takes in the samples they added.
+	stageTimers[INDIRECT]->begin();
+
+	traceIndirectRaysSP->bind();
+	traceIndirectRaysSP->setUniform3f("u_view_position", camera.getPosition());
+	traceIndirectRaysSP->setUniform1i("u_indirect_mode", indirectMode);
+	traceIndirectRaysSP->setUniform1i("u_sampler", sampler);
+	traceIndirectRaysSP->setUniform1ui("u_sample_index", sampleIndex);
+	traceIndirectRaysSP->setUniform1ui("u_cache_frame", cacheFrame);
+	traceIndirectRaysSP->setUniform1fv("u_texture_lods", textureLayerCount, textureLods.data());
+	traceIndirectRaysSP->setUniform1i("u_texture_layer_count", textureLayerCount);
+
+	glDispatchCompute((unsigned int)(width + 7) / 8, (unsigned int)(height + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	if (indirectMode == INDIRECT_CACHED || cacheInvalidationPending)
+	{
+		updateIrradianceCacheSP->bind();
+		updateIrradianceCacheSP->setUniform1ui("u_cache_frame", cacheFrame);
+		updateIrradianceCacheSP->setUniform1i("u_cache_invalidate", cacheInvalidationPending);
+		updateIrradianceCacheSP->setUniform3f("u_cache_invalidate_min", cacheInvalidationMin);
+		updateIrradianceCacheSP->setUniform3f("u_cache_invalidate_max", cacheInvalidationMax);
+
+		glDispatchCompute(IrradianceCache::CAPACITY / 256, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		cacheInvalidationPending = false;
+		cacheFrame += 1;
+	}
+
+	stageTimers[INDIRECT]->end();
+
+	stageTimers[RESOLVE]->begin();
+
+	outputTex->bindImage(0, GL_WRITE_ONLY, GL_RGBA32F); // "u_image_output".
+
+	renderOutputTexSP->bind();
+	renderOutputTexSP->setUniform1ui("u_sample_index", sampleIndex);
+
+	glDispatchCompute((unsigned int)(width + 7) / 8, (unsigned int)(height + 7) / 8, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT); // Make sure writing to image has finished before read.
+
+	renderOutputTexSP->unbind();
+
+	stageTimers[RESOLVE]->end();
+
+	for (int i = 0; i < STAGE_COUNT; i++)
+	{
+		stageMilliseconds[i] = stageTimers[i]->getMilliseconds();
+	}
+
+	endSample();
+}
+
+const char* GpuRenderer::getName()
+{
+	return "GPU";
+}
+
+void GpuRenderer::updateScene(const Scene& scene, Bvh* bvh, const glm::vec3& changedMin, const glm::vec3& changedMax)
+{
+	deleteScene();
+	uploadScene(scene, bvh, NULL); // Edited, so only the copy is up to date.
+
+	invalidateCache(changedMin, changedMax);
+}
+
+void GpuRenderer::clearCache()
+{
+	// Free slots and empty accumulators are all zeros.
+	cacheCellsSSBO->clear();
+	cacheAccumulatorsSSBO->clear();
+
+	cacheFrame = 0;
+	cacheInvalidationPending = false;
+
+	resetAccumulation();
+}
+
+void GpuRenderer::uploadScene(const Scene& scene, Bvh* bvh, const SceneFileSections* sections)
+{
+	lightsSSBO = createSceneSSBO(scene.lights, sections ? &sections->lights : NULL);
+	materialsSSBO = createSceneSSBO(scene.materials, sections ? &sections->materials : NULL);
+	spheresSSBO = createSceneSSBO(scene.spheres, sections ? &sections->spheres : NULL);
+	planesSSBO = createSceneSSBO(scene.planes, sections ? &sections->planes : NULL);
+	trianglesSSBO = createSceneSSBO(scene.triangles, sections ? &sections->triangles : NULL);
+	bvhNodesSSBO = createSceneSSBO(bvh->getWideNodes(), sections ? &sections->wideNodes : NULL);
+	bvhPrimitivesSSBO = createSceneSSBO(bvh->getWidePrimitives(), sections ? &sections->widePrimitives : NULL);
+
+	glm::vec3 sceneMin, sceneMax;
+
+	scene.computeBounds(sceneMin, sceneMax);
+
+	// Scene uniforms only change with the scene, only the ones each program actually uses are set.
+	tracePrimaryRaysSP->bind();
+	tracePrimaryRaysSP->setUniform1i("u_light_count", lightCount);
+	tracePrimaryRaysSP->setUniform1i("u_bvh_node_count", (int)bvh->getWideNodes().size());
+	tracePrimaryRaysSP->setUniform3f("u_scene_min", sceneMin);
+	tracePrimaryRaysSP->setUniform3f("u_scene_max", sceneMax);
+
+	traceShadowRaysSP->bind();
+	traceShadowRaysSP->setUniform1i("u_bvh_node_count", (int)bvh->getWideNodes().size());
+
+	traceIndirectRaysSP->bind();
+	traceIndirectRaysSP->setUniform1i("u_light_count", lightCount);
+	traceIndirectRaysSP->setUniform1i("u_bvh_node_count", (int)bvh->getWideNodes().size());
+
+	renderOutputTexSP->bind();
+	renderOutputTexSP->setUniform1i("u_light_count", lightCount);
+	renderOutputTexSP->setUniform3f("u_background_color", scene.backgroundColor);
+	renderOutputTexSP->unbind();
+}
+
+void GpuRenderer::deleteScene()
+{
+	delete lightsSSBO;
+	delete materialsSSBO;
+	delete spheresSSBO;
+	delete planesSSBO;
+	delete trianglesSSBO;
+	delete bvhNodesSSBO;
+	delete bvhPrimitivesSSBO;
+}
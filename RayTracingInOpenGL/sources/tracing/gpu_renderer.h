@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "renderer.h"
+#include "scene.h"
+#include "scene_file.h"
+#include "bvh.h"
+#include "sampler.h"
+#include "irradiance_cache.h"
+
+#include "../graphics/shader.h"
+#include "../graphics/ssbo.h"
+#include "../graphics/gpu_timer.h"
+#include "../graphics/texture_loader.h"
+
+// Wavefront compute pipeline: primary rays emit one shadow ray per light into a queue, which is optionally reordered
+// by a radix sort over Morton-style ray keys before being traced, then the indirect pass traces a path per pixel
+// (filling in and querying the irradiance cache, updated right after), and the resolve pass shades every pixel.
+//
+// The indirect rays are not sorted: a path keeps its state in registers across bounces, so sorting them would take a
+// queue and a sort per bounce, and in the cached mode only about one pixel in IrradianceCache::TRAINING_STRIDE traces
+// a path at all. The ray sort probe (F7) reports the indirect stage alongside the sorted ones to keep this in check.
+//
+class GpuRenderer : public Renderer
+{
+public:
+	// The scene buffers are created from "sections" where it has them, which need not outlive the constructor.
+	GpuRenderer(const Scene& scene, Bvh* bvh, int width, int height, TextureLoader* textureLoader, const SceneFileSections* sections = NULL);
+	~GpuRenderer();
+
+	void render(Camera& camera, float fov, Texture* outputTex) override;
+	const char* getName() override;
+
+	void updateScene(const Scene& scene, Bvh* bvh, const glm::vec3& changedMin, const glm::vec3& changedMax) override;
+	void clearCache() override;
+
+private:
+	// Must match "shaders/common/scene.glsl", "shaders/common/wavefront.glsl", "shaders/common/sampler.glsl" and
+	// "shaders/common/irradiance_cache.glsl".
+	enum Binding
+	{
+		LIGHTS, MATERIALS, SPHERES, PLANES, SURFACES, SHADOW_RAYS, SORT_PAIRS, SORT_PAIRS_OUT, SORT_HISTOGRAM, VISIBILITY, BVH_NODES, BVH_PRIMITIVES, TRIANGLES,
+		BLUE_NOISE, ACCUMULATION, INDIRECT_IRRADIANCE, CACHE_CELLS, CACHE_ACCUMULATORS
+	};
+
+	static const int SORT_GROUP_SIZE = 256;
+	static const int SORT_KEY_BITS = 30;
+	static const int SHADOW_RAYS_HEADER_SIZE = 32; // Ray counter and indirect dispatch arguments, see "ShadowRays".
+	static const int SHADOW_RAY_GROUPS_OFFSET = 16;
+
+	int width, height, lightCount;
+
+	TextureLoader* textureLoader;
+
+	ShaderProgram* tracePrimaryRaysSP;
+	ShaderProgram* prepareShadowRaysSP;
+	ShaderProgram* radixSortHistogramSP;
+	ShaderProgram* radixSortScanSP;
+	ShaderProgram* radixSortScatterSP;
+	ShaderProgram* traceShadowRaysSP;
+	ShaderProgram* traceIndirectRaysSP;
+	ShaderProgram* updateIrradianceCacheSP;
+	ShaderProgram* renderOutputTexSP;
+
+	SSBO* lightsSSBO;
+	SSBO* materialsSSBO;
+	SSBO* spheresSSBO;
+	SSBO* planesSSBO;
+	SSBO* trianglesSSBO;
+	SSBO* bvhNodesSSBO;
+	SSBO* bvhPrimitivesSSBO;
+	SSBO* surfacesSSBO;
+	SSBO* shadowRaysSSBO;
+	SSBO* sortPairsSSBOs[2];
+	SSBO* sortHistogramSSBO;
+	SSBO* visibilitySSBO;
+	SSBO* blueNoiseSSBO;
+	SSBO* accumulationSSBO;
+	SSBO* indirectSSBO;
+	SSBO* cacheCellsSSBO;
+	SSBO* cacheAccumulatorsSSBO;
+
+	GpuTimer* stageTimers[STAGE_COUNT];
+
+	// Creates the scene buffers and sets the scene uniforms.
+	void uploadScene(const Scene& scene, Bvh* bvh, const SceneFileSections* sections);
+	void deleteScene();
+};
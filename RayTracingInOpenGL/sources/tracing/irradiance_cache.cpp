@@ -0,0 +1,186 @@
+#include "irradiance_cache.h"
+
+const float IrradianceCache::CELL_SCALE = 1.0f / 64.0f;
+const float IrradianceCache::FIXED_POINT_SCALE = 4096.0f;
+const float IrradianceCache::MAX_SAMPLE_VALUE = 16.0f; // Samples are clamped, so that a cell can sum many of them.
+
+IrradianceCache::IrradianceCache()
+	: frame(0), cells(CAPACITY)
+{
+	static_assert(sizeof(Cell) == 56, "The irradiance cache cell layout changed.");
+
+	clear();
+}
+
+void IrradianceCache::clear()
+{
+	for (Cell& cell : cells)
+	{
+		cell.key = 0;
+		cell.lastFrame = 0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			cell.accumulator[i] = 0;
+		}
+
+		cell.center = glm::vec3(0.0f);
+		cell.halfSize = 0.0f;
+		cell.irradiance = glm::vec3(0.0f);
+		cell.sampleCount = 0;
+	}
+}
+
+void IrradianceCache::beginFrame(unsigned int frame)
+{
+	this->frame = frame;
+}
+
+float IrradianceCache::getCellSize(const glm::vec3& point, const glm::vec3& viewPosition)
+{
+	return std::ldexp(1.0f, cellLevel(point, viewPosition));
+}
+
+glm::vec2 IrradianceCache::getJitter(unsigned int pixel, unsigned int sampleIndex)
+{
+	unsigned int hash = Sampler::hash(Sampler::hashCombine(Sampler::hash(pixel), sampleIndex));
+
+	return glm::vec2((float)(hash & 0xFFFFu), (float)(hash >> 16)) * (1.0f / 65536.0f);
+}
+
+bool IrradianceCache::isTrainingPixel(unsigned int pixel)
+{
+	return Sampler::hash(pixel ^ Sampler::hash(frame)) % TRAINING_STRIDE == 0;
+}
+
+unsigned int IrradianceCache::find(const glm::vec3& point, const glm::vec3& normal, const glm::vec3& viewPosition, bool insert)
+{
+	glm::vec3 center;
+	float halfSize;
+
+	unsigned int hash = cellHash(point, normal, viewPosition, center, halfSize);
+	unsigned int checksum = Sampler::hash(hash + 1u) | 1u;
+
+	for (unsigned int i = 0; i < PROBE_COUNT; i++)
+	{
+		unsigned int slot = (hash + i) & (CAPACITY - 1);
+		Cell& cell = cells[slot];
+
+		unsigned int key = cell.key.load(std::memory_order_relaxed);
+
+		if (key == 0)
+		{
+			if (!insert) return NOT_FOUND; // Cells are claimed in probing order, none goes past a free slot.
+
+			if (cell.key.compare_exchange_strong(key, checksum))
+			{
+				cell.center = center;
+				cell.halfSize = halfSize;
+				cell.lastFrame.store(frame, std::memory_order_relaxed);
+
+				return slot;
+			}
+		}
+
+		if (key == checksum) return slot;
+	}
+
+	return NOT_FOUND;
+}
+
+bool IrradianceCache::query(const glm::vec3& point, const glm::vec3& normal, const glm::vec3& viewPosition, glm::vec3& irradiance)
+{
+	irradiance = glm::vec3(0.0f);
+
+	unsigned int slot = find(point, normal, viewPosition, false);
+
+	if (slot == NOT_FOUND || cells[slot].sampleCount == 0) return false;
+
+	irradiance = cells[slot].irradiance;
+	cells[slot].lastFrame.store(frame, std::memory_order_relaxed);
+
+	return true;
+}
+
+void IrradianceCache::addSample(unsigned int slot, const glm::vec3& irradiance)
+{
+	glm::uvec3 value = glm::uvec3(glm::clamp(irradiance, 0.0f, MAX_SAMPLE_VALUE) * FIXED_POINT_SCALE + 0.5f);
+
+	Cell& cell = cells[slot];
+
+	cell.accumulator[0].fetch_add(value.x, std::memory_order_relaxed);
+	cell.accumulator[1].fetch_add(value.y, std::memory_order_relaxed);
+	cell.accumulator[2].fetch_add(value.z, std::memory_order_relaxed);
+	cell.accumulator[3].fetch_add(1, std::memory_order_relaxed);
+
+	cell.lastFrame.store(frame, std::memory_order_relaxed);
+}
+
+void IrradianceCache::update(bool invalidate, const glm::vec3& invalidateMin, const glm::vec3& invalidateMax, ThreadPool* threadPool)
+{
+	// Mirror of "shaders/update_irradiance_cache_cs.glsl".
+	threadPool->parallelFor((int)CAPACITY, 16384, [&](int begin, int end)
+	{
+		for (int slot = begin; slot < end; slot++)
+		{
+			Cell& cell = cells[slot];
+
+			if (cell.key.load(std::memory_order_relaxed) == 0) continue;
+
+			glm::uvec4 accumulator;
+
+			for (int i = 0; i < 4; i++)
+			{
+				accumulator[i] = cell.accumulator[i].exchange(0, std::memory_order_relaxed);
+			}
+
+			bool invalidated = invalidate && glm::all(glm::greaterThanEqual(cell.center + cell.halfSize, invalidateMin))
+				&& glm::all(glm::lessThanEqual(cell.center - cell.halfSize, invalidateMax));
+
+			if (invalidated || frame - cell.lastFrame.load(std::memory_order_relaxed) > MAX_AGE)
+			{
+				cell.key = 0;
+				cell.sampleCount = 0;
+
+				continue;
+			}
+
+			if (accumulator.w == 0) continue;
+
+			// Running average over at most the last MAX_SAMPLES samples, so that cells keep following the lighting.
+			glm::vec3 mean = glm::vec3(accumulator.x, accumulator.y, accumulator.z) / (FIXED_POINT_SCALE * (float)accumulator.w);
+			unsigned int sampleCount = std::min(cell.sampleCount + accumulator.w, MAX_SAMPLES);
+
+			cell.irradiance = glm::mix(cell.irradiance, mean, std::min((float)accumulator.w / (float)sampleCount, 1.0f));
+			cell.sampleCount = sampleCount;
+		}
+	});
+}
+
+int IrradianceCache::cellLevel(const glm::vec3& point, const glm::vec3& viewPosition)
+{
+	return glm::clamp((int)std::floor(std::log2(std::max(glm::length(point - viewPosition) * CELL_SCALE, 1e-6f))), -16, 15);
+}
+
+unsigned int IrradianceCache::cellHash(const glm::vec3& point, const glm::vec3& normal, const glm::vec3& viewPosition, glm::vec3& center, float& halfSize)
+{
+	// Mirror of "cache_cell_hash()" in "shaders/common/irradiance_cache.glsl".
+	int level = cellLevel(point, viewPosition);
+	float size = std::ldexp(1.0f, level);
+
+	glm::ivec3 cell = glm::ivec3(glm::floor(point / size));
+
+	glm::vec3 a = glm::abs(normal);
+	unsigned int axis = a.x >= a.y && a.x >= a.z ? 0u : (a.y >= a.z ? 1u : 2u);
+	unsigned int side = normal[axis] < 0.0f ? 1u : 0u;
+
+	center = (glm::vec3(cell) + 0.5f) * size;
+	halfSize = 0.5f * size;
+
+	unsigned int hash = Sampler::hash((unsigned int)cell.x);
+
+	hash = Sampler::hash(Sampler::hashCombine(hash, (unsigned int)cell.y));
+	hash = Sampler::hash(Sampler::hashCombine(hash, (unsigned int)cell.z));
+
+	return Sampler::hash(Sampler::hashCombine(hash, (unsigned int)(level + 16) | ((axis * 2u + side) << 5)));
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cmath>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "sampler.h"
+
+#include "../utils/thread_pool.h"
+
+// World-space cache of the diffuse indirect irradiance, mirrored by "shaders/common/irradiance_cache.glsl" on the GPU.
+//
+// Cells are axis aligned cubes whose size is a power of two chosen from the distance to the camera (about 1/64 of it),
+// split by the major axis of the surface normal, and stored in a hash table with linear probing. Every frame, about
+// one pixel in TRAINING_STRIDE (and every pixel the cache knows nothing about yet) traces a path, which claims the
+// cells it goes through and adds its samples to per cell fixed-point accumulators, with integer atomics only, so that
+// the result does not depend on the order of the samples. Once per frame, update() blends the new samples into a
+// running average over the last MAX_SAMPLES samples, clears the cells overlapping the edited parts of the scene, and
+// evicts the cells nothing used for MAX_AGE frames.
+//
+// Evicting a cell may cut the probing sequence of the cells after it, which are then claimed again in the freed slot
+// while their old copy ages out.
+//
+class IrradianceCache
+{
+public:
+	static const unsigned int NOT_FOUND = 0xFFFFFFFFu;
+
+	// Must match "shaders/common/irradiance_cache.glsl".
+	static const unsigned int CAPACITY = 262144; // Power of two.
+	static const unsigned int PROBE_COUNT = 8;
+	static const unsigned int TRAINING_STRIDE = 16;
+	static const int CELL_SIZE = 48; // Bytes of a "CacheCell".
+	static const int ACCUMULATOR_SIZE = 16;
+
+	static const unsigned int MAX_SAMPLES = 1024;
+	static const unsigned int MAX_AGE = 120; // In frames.
+
+	IrradianceCache();
+
+	void clear(); // Frees every slot. Not thread safe, unlike the lookups.
+
+	void beginFrame(unsigned int frame);
+
+	// Edge length of the cells around "point".
+	static float getCellSize(const glm::vec3& point, const glm::vec3& viewPosition);
+
+	// Offset of the lookup point of the pixel over the cell, in [0, 1)^2. Plain white noise is enough to blend the
+	// cells, and much cheaper than the sampler.
+	static glm::vec2 getJitter(unsigned int pixel, unsigned int sampleIndex);
+
+	// Whether the pixel traces a path to fill in the cache this frame, spread differently every frame.
+	bool isTrainingPixel(unsigned int pixel);
+
+	// Slot of the cell containing "point", NOT_FOUND if it is not in the cache. Claims a free slot for it when "insert"
+	// is set, unless the probing sequence is full. Thread safe, like query() and addSample().
+	unsigned int find(const glm::vec3& point, const glm::vec3& normal, const glm::vec3& viewPosition, bool insert);
+
+	// Cached irradiance at "point", false if its cell has not been filled in yet.
+	bool query(const glm::vec3& point, const glm::vec3& normal, const glm::vec3& viewPosition, glm::vec3& irradiance);
+
+	void addSample(unsigned int slot, const glm::vec3& irradiance);
+
+	// Once every sample of the frame was added. Cells overlapping [invalidateMin, invalidateMax] are cleared if
+	// "invalidate" is set.
+	void update(bool invalidate, const glm::vec3& invalidateMin, const glm::vec3& invalidateMax, ThreadPool* threadPool);
+
+private:
+	// Everything about a cell is kept together (56 bytes, not aligned on cache lines), so that a lookup touches one or
+	// two cache lines; the GPU keeps the accumulators apart instead.
+	struct Cell
+	{
+		std::atomic<unsigned int> key; // Checksum of the cell, 0 when the slot is free.
+		std::atomic<unsigned int> lastFrame;
+		std::atomic<unsigned int> accumulator[4]; // Fixed-point RGB sums, then the sample count.
+
+		glm::vec3 center;
+		float halfSize;
+
+		glm::vec3 irradiance;
+		unsigned int sampleCount;
+	};
+
+	static const float CELL_SCALE;
+	static const float FIXED_POINT_SCALE;
+	static const float MAX_SAMPLE_VALUE;
+
+	unsigned int frame;
+
+	std::vector<Cell> cells;
+
+	static int cellLevel(const glm::vec3& point, const glm::vec3& viewPosition);
+	static unsigned int cellHash(const glm::vec3& point, const glm::vec3& normal, const glm::vec3& viewPosition, glm::vec3& center, float& halfSize);
+};
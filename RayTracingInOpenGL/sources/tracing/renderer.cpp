@@ -0,0 +1,100 @@
+#include "renderer.h"
+
+Renderer::Renderer()
+	: sortRays(false), sampler(Sampler::SOBOL), sampleIndex(0), indirectMode(INDIRECT_CACHED), cacheFrame(0), cacheInvalidationPending(false),
+	  cacheInvalidationMin(0.0f), cacheInvalidationMax(0.0f), stageMilliseconds(), lastViewMatrix(0.0f), lastFov(0.0f)
+{
+}
+
+Renderer::~Renderer()
+{
+}
+
+const char* Renderer::getIndirectModeName(IndirectMode mode)
+{
+	static const char* names[INDIRECT_MODE_COUNT] = { "no indirect", "cached indirect", "path traced indirect" };
+
+	return names[mode];
+}
+
+void Renderer::setSortRays(bool sortRays)
+{
+	this->sortRays = sortRays;
+}
+
+bool Renderer::getSortRays()
+{
+	return sortRays;
+}
+
+void Renderer::setSampler(Sampler::Type sampler)
+{
+	this->sampler = sampler;
+
+	resetAccumulation();
+}
+
+Sampler::Type Renderer::getSampler()
+{
+	return sampler;
+}
+
+void Renderer::setIndirectMode(IndirectMode indirectMode)
+{
+	this->indirectMode = indirectMode;
+
+	resetAccumulation();
+}
+
+Renderer::IndirectMode Renderer::getIndirectMode()
+{
+	return indirectMode;
+}
+
+unsigned int Renderer::getSampleCount()
+{
+	return sampleIndex;
+}
+
+void Renderer::resetAccumulation()
+{
+	sampleIndex = 0;
+}
+
+float Renderer::getStageMilliseconds(Stage stage)
+{
+	return stageMilliseconds[stage];
+}
+
+void Renderer::beginSample(Camera& camera, float fov, const std::vector<float>& textureLods)
+{
+	if (camera.getViewMatrix() != lastViewMatrix || fov != lastFov || textureLods != lastTextureLods)
+	{
+		lastViewMatrix = camera.getViewMatrix();
+		lastFov = fov;
+		lastTextureLods = textureLods;
+
+		sampleIndex = 0;
+	}
+}
+
+void Renderer::endSample()
+{
+	sampleIndex += 1;
+}
+
+void Renderer::invalidateCache(const glm::vec3& changedMin, const glm::vec3& changedMax)
+{
+	// Light bounced off or blocked by the changed objects mostly lands within about their own size of them.
+	glm::vec3 extent = changedMax - changedMin;
+	float margin = std::max(extent.x, std::max(extent.y, extent.z));
+
+	glm::vec3 regionMin = changedMin - margin;
+	glm::vec3 regionMax = changedMax + margin;
+
+	cacheInvalidationMin = cacheInvalidationPending ? glm::min(cacheInvalidationMin, regionMin) : regionMin;
+	cacheInvalidationMax = cacheInvalidationPending ? glm::max(cacheInvalidationMax, regionMax) : regionMax;
+	cacheInvalidationPending = true;
+
+	resetAccumulation();
+}
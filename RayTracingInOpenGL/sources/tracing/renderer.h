@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "scene.h"
+#include "bvh.h"
+#include "sampler.h"
+
+#include "../graphics/texture.h"
+#include "../utils/camera.h"
+
+// Common interface of the GPU and CPU backends. Both trace the same wavefront stages and write the final image into
+// the output texture, so they can be swapped at runtime and compared stage by stage.
+//
+// Every render() traces one jittered sample per pixel and adds it to a running average, which restarts whenever the
+// view, the sampler, the indirect lighting mode, the scene or the resident textures change.
+//
+// Indirect lighting is gathered with cosine distributed paths from the primary hits. In the cached mode, a path stops
+// at its first hit whose irradiance is known to the world-space "IrradianceCache" (usually the first one), and fills
+// in the cache with its samples. The cache persists across frames and view changes, and is only cleared around the
+// regions of the scene that are edited, or as a whole by clearCache().
+//
+class Renderer
+{
+public:
+	enum Stage { PRIMARY, SORT, SHADOW, INDIRECT, RESOLVE, STAGE_COUNT };
+
+	enum IndirectMode { INDIRECT_OFF, INDIRECT_CACHED, INDIRECT_PATHS, INDIRECT_MODE_COUNT };
+
+	static const int INDIRECT_BOUNCES = 4; // Longest indirect path, which the cached mode only traces on cache misses.
+
+	static const char* getIndirectModeName(IndirectMode mode);
+
+	Renderer();
+	virtual ~Renderer();
+
+	virtual void render(Camera& camera, float fov, Texture* outputTex) = 0;
+	virtual const char* getName() = 0;
+
+	// Uploads an edited version of the scene, and clears the cached irradiance around the changed region. The lights
+	// must stay the same, and "bvh" alive until the next update.
+	virtual void updateScene(const Scene& scene, Bvh* bvh, const glm::vec3& changedMin, const glm::vec3& changedMax) = 0;
+
+	// Empties the whole irradiance cache and restarts its frame count, so that the next frames render as if it had
+	// just been created.
+	virtual void clearCache() = 0;
+
+	void setSortRays(bool sortRays);
+	bool getSortRays();
+
+	void setSampler(Sampler::Type sampler);
+	Sampler::Type getSampler();
+
+	void setIndirectMode(IndirectMode indirectMode);
+	IndirectMode getIndirectMode();
+
+	unsigned int getSampleCount(); // Samples averaged in the latest image.
+	void resetAccumulation();
+
+	float getStageMilliseconds(Stage stage); // Latest measurement of each stage.
+
+protected:
+	bool sortRays;
+
+	Sampler::Type sampler;
+	unsigned int sampleIndex; // Index of the sample traced by the current render(), 0 restarts the average.
+
+	IndirectMode indirectMode;
+	unsigned int cacheFrame; // Frames rendered so far, which age the cells of the irradiance cache.
+
+	// Region whose cached irradiance is cleared by the next cache update.
+	bool cacheInvalidationPending;
+	glm::vec3 cacheInvalidationMin, cacheInvalidationMax;
+
+	float stageMilliseconds[STAGE_COUNT];
+
+	// Called at the start of render(), restarts the average if anything it depends on changed since the last sample.
+	void beginSample(Camera& camera, float fov, const std::vector<float>& textureLods);
+	void endSample();
+
+	// Adds the surroundings of a changed region to the pending cache invalidation and restarts the average.
+	void invalidateCache(const glm::vec3& changedMin, const glm::vec3& changedMax);
+
+private:
+	glm::mat4 lastViewMatrix;
+	float lastFov;
+
+	std::vector<float> lastTextureLods;
+};
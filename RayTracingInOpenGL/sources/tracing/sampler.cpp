@@ -0,0 +1,224 @@
+#include "sampler.h"
+
+static std::vector<unsigned int> createBlueNoiseMask(int size)
+{
+	// Void-and-cluster (Ulichney 1993) on a torus. The energy of a pixel is the sum of a Gaussian of its distance to
+	// every set pixel; clusters are set pixels of highest energy, voids unset pixels of lowest energy.
+	const float sigma = 1.9f;
+
+	int pixelCount = size * size;
+
+	std::vector<float> kernel(pixelCount);
+
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			float dx = (float)std::min(x, size - x), dy = (float)std::min(y, size - y);
+
+			kernel[y * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+		}
+	}
+
+	std::vector<unsigned char> pattern(pixelCount, 0);
+	std::vector<float> energy(pixelCount, 0.0f);
+
+	auto toggle = [&](int pixel, bool set)
+	{
+		pattern[pixel] = set ? 1 : 0;
+
+		int px = pixel % size, py = pixel / size;
+		float sign = set ? 1.0f : -1.0f;
+
+		for (int y = 0; y < size; y++)
+		{
+			const float* kernelRow = &kernel[((y - py + size) % size) * size];
+			float* energyRow = &energy[y * size];
+
+			for (int x = 0; x < size; x++)
+			{
+				energyRow[x] += sign * kernelRow[(x - px + size) % size];
+			}
+		}
+	};
+
+	auto find = [&](bool cluster)
+	{
+		int best = -1;
+
+		for (int i = 0; i < pixelCount; i++)
+		{
+			if (pattern[i] != (cluster ? 1 : 0)) continue;
+
+			if (best < 0 || (cluster ? energy[i] > energy[best] : energy[i] < energy[best])) best = i;
+		}
+
+		return best;
+	};
+
+	// Random initial pattern of a tenth of the pixels, relaxed until moving its tightest cluster into its largest void
+	// no longer changes anything.
+	std::mt19937 generator(7);
+	int initialCount = pixelCount / 10;
+
+	for (int count = 0; count < initialCount; )
+	{
+		int pixel = (int)(generator() % (unsigned int)pixelCount);
+
+		if (pattern[pixel]) continue;
+
+		toggle(pixel, true);
+		count++;
+	}
+
+	for (int iteration = 0; iteration < pixelCount; iteration++)
+	{
+		int cluster = find(true);
+
+		toggle(cluster, false);
+
+		int largestVoid = find(false);
+
+		toggle(largestVoid, true);
+
+		if (largestVoid == cluster) break;
+	}
+
+	std::vector<unsigned char> initialPattern = pattern;
+	std::vector<float> initialEnergy = energy;
+	std::vector<unsigned int> ranks(pixelCount);
+
+	// Ranks of the initial pattern, removing its tightest clusters first.
+	for (int rank = initialCount - 1; rank >= 0; rank--)
+	{
+		int cluster = find(true);
+
+		toggle(cluster, false);
+		ranks[cluster] = (unsigned int)rank;
+	}
+
+	// Ranks of the remaining pixels, filling the largest voids first.
+	pattern = initialPattern;
+	energy = initialEnergy;
+
+	for (int rank = initialCount; rank < pixelCount; rank++)
+	{
+		int largestVoid = find(false);
+
+		toggle(largestVoid, true);
+		ranks[largestVoid] = (unsigned int)rank;
+	}
+
+	return ranks;
+}
+
+const char* Sampler::getTypeName(Type type)
+{
+	switch (type)
+	{
+	case RANDOM: return "random";
+	case SOBOL: return "Owen-scrambled Sobol";
+	case BLUE_NOISE: return "blue noise Sobol";
+	default: return "unknown";
+	}
+}
+
+const std::vector<unsigned int>& Sampler::getBlueNoiseMask()
+{
+	static const std::vector<unsigned int> mask = createBlueNoiseMask(BLUE_NOISE_SIZE);
+
+	return mask;
+}
+
+float Sampler::get(Type type, unsigned int pixelX, unsigned int pixelY, unsigned int sampleIndex, unsigned int dimension)
+{
+	unsigned int pixelSeed = hash((pixelX & 0xFFFFu) | (pixelY << 16));
+	unsigned int value;
+
+	if (type == RANDOM)
+	{
+		value = hash(hashCombine(hashCombine(pixelSeed, sampleIndex), dimension));
+	}
+	else if (type == SOBOL)
+	{
+		value = sobolOwen(pixelSeed, sampleIndex, dimension);
+	}
+	else
+	{
+		// Each dimension reads the mask at a different offset, so that they are not correlated with each other.
+		const std::vector<unsigned int>& mask = getBlueNoiseMask();
+
+		unsigned int x = (pixelX + dimension * 23u) % BLUE_NOISE_SIZE;
+		unsigned int y = (pixelY + dimension * 41u) % BLUE_NOISE_SIZE;
+		unsigned int shift = mask[y * BLUE_NOISE_SIZE + x] * (0xFFFFFFFFu / (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE));
+
+		value = sobolOwen(0u, sampleIndex, dimension) + shift;
+	}
+
+	return (float)(value >> 8) * (1.0f / 16777216.0f);
+}
+
+unsigned int Sampler::hash(unsigned int x)
+{
+	// "lowbias32" by Chris Wellons.
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+
+	return x;
+}
+
+unsigned int Sampler::hashCombine(unsigned int seed, unsigned int value)
+{
+	return seed ^ (value + 0x9E3779B9u + (seed << 6) + (seed >> 2));
+}
+
+unsigned int Sampler::reverseBits(unsigned int x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+
+	return (x >> 16) | (x << 16);
+}
+
+unsigned int Sampler::nestedUniformScramble(unsigned int x, unsigned int seed)
+{
+	// Laine-Karras style permutation on the reversed bits: every bit only depends on the bits above it.
+	x = reverseBits(x);
+
+	x += seed;
+	x ^= x * 0x6C50B47Cu;
+	x ^= x * 0xB82F1E52u;
+	x ^= x * 0xC7AFE638u;
+	x ^= x * 0x8D22F6E6u;
+
+	return reverseBits(x);
+}
+
+unsigned int Sampler::sobol(unsigned int index, unsigned int dimension)
+{
+	// First dimension: van der Corput. Second one: direction numbers of the primitive polynomial x + 1.
+	if (dimension == 0) return reverseBits(index);
+
+	unsigned int result = 0;
+
+	for (unsigned int direction = 0x80000000u; index != 0; index >>= 1, direction ^= direction >> 1)
+	{
+		if (index & 1u) result ^= direction;
+	}
+
+	return result;
+}
+
+unsigned int Sampler::sobolOwen(unsigned int seed, unsigned int sampleIndex, unsigned int dimension)
+{
+	// Both dimensions of a pair share the same shuffled index, so the pair stays a (0, 2)-sequence.
+	unsigned int pairSeed = hash(hashCombine(seed, dimension >> 1));
+	unsigned int index = nestedUniformScramble(sampleIndex, pairSeed);
+
+	return nestedUniformScramble(sobol(index, dimension & 1u), hash(hashCombine(pairSeed, (dimension & 1u) + 1u)));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+// Sample generator shared by both backends, mirrored bit for bit by "shaders/common/sampler.glsl": integer arithmetic
+// only, so that the GPU and CPU backends draw exactly the same samples. Samples are indexed by pixel, sample index
+// (the number of samples already accumulated in the pixel) and dimension.
+//
+// Sobol samples are Owen scrambled with the hash-based nested uniform scrambling of Burley ("Practical Hash-based
+// Owen Scrambling", 2020). Only the first two Sobol dimensions are used: higher dimensions are padded with further
+// (x, y) pairs, each scrambled and shuffled with its own seed, which keeps every pair well stratified.
+//
+// RANDOM:     white noise, the baseline.
+// SOBOL:      an independently scrambled Sobol sequence per pixel.
+// BLUE_NOISE: the same scrambled Sobol sequence for every pixel, toroidally shifted by a per pixel blue noise value,
+//             so that the error left after a few samples is spread as blue noise rather than white noise on screen.
+//
+class Sampler
+{
+public:
+	enum Type { RANDOM, SOBOL, BLUE_NOISE, TYPE_COUNT };
+
+	static const int BLUE_NOISE_SIZE = 64; // Must match "BLUE_NOISE_SIZE" in "shaders/common/sampler.glsl".
+
+	static const char* getTypeName(Type type);
+
+	// Ranks (0 to BLUE_NOISE_SIZE^2 - 1) of a tileable void-and-cluster blue noise mask, generated on first use.
+	static const std::vector<unsigned int>& getBlueNoiseMask();
+
+	// Value in [0, 1), with 24 bits of precision.
+	static float get(Type type, unsigned int pixelX, unsigned int pixelY, unsigned int sampleIndex, unsigned int dimension);
+
+	// Integer hashes the samples are built from, also used to index the irradiance cache.
+	static unsigned int hash(unsigned int x);
+	static unsigned int hashCombine(unsigned int seed, unsigned int value);
+
+private:
+	static unsigned int reverseBits(unsigned int x);
+	static unsigned int nestedUniformScramble(unsigned int x, unsigned int seed);
+	static unsigned int sobol(unsigned int index, unsigned int dimension);
+	static unsigned int sobolOwen(unsigned int seed, unsigned int sampleIndex, unsigned int dimension);
+};
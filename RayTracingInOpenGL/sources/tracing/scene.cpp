@@ -0,0 +1,62 @@
+#include "scene.h"
+
+void Scene::computeBounds(glm::vec3& minimum, glm::vec3& maximum) const
+{
+	minimum = glm::vec3(1e32f);
+	maximum = glm::vec3(-1e32f);
+
+	for (const Sphere& sphere : spheres)
+	{
+		minimum = glm::min(minimum, sphere.center - sphere.radius);
+		maximum = glm::max(maximum, sphere.center + sphere.radius);
+	}
+
+	for (const Plane& plane : planes)
+	{
+		minimum = glm::min(minimum, glm::vec3(-plane.xSize, plane.yPosition, -plane.zSize));
+		maximum = glm::max(maximum, glm::vec3(plane.xSize, plane.yPosition, plane.zSize));
+	}
+
+	for (const Triangle& triangle : triangles)
+	{
+		minimum = glm::min(minimum, glm::min(triangle.vertex0, glm::min(triangle.vertex1, triangle.vertex2)));
+		maximum = glm::max(maximum, glm::max(triangle.vertex0, glm::max(triangle.vertex1, triangle.vertex2)));
+	}
+
+	if (minimum.x > maximum.x) // Empty scene.
+	{
+		minimum = glm::vec3(0.0f);
+		maximum = glm::vec3(0.0f);
+	}
+}
+
+Scene createDefaultScene(int extraSphereCount)
+{
+	Scene scene;
+
+	scene.backgroundColor = glm::vec3(0.2f, 0.4f, 0.8f);
+
+	scene.lights.push_back({ glm::vec3(5.0f, 5.0f, 5.0f), 1.5f, glm::vec3(1.0f, 1.0f, 1.0f), 0.5f });
+
+	scene.materials.push_back({ glm::vec3(0.75f, 0.15f, 0.75f), 0 });
+	scene.materials.push_back({ glm::vec3(0.4f, 0.8f, 0.4f), 1 });
+
+	scene.spheres.push_back({ glm::vec3(0.0f, 0.0f, 0.0f), 1.0f, 0, { 0, 0, 0 } });
+
+	scene.planes.push_back({ glm::vec3(0.0f, 1.0f, 0.0f), -2.0f, 10.0f, 10.0f, 1, 0 });
+
+	// Always the same layout, with radii shrinking as their count grows so that the spheres keep a similar coverage.
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+	float radius = 2.0f / std::sqrt((float)std::max(extraSphereCount, 1));
+
+	for (int i = 0; i < extraSphereCount; i++)
+	{
+		glm::vec3 center(uniform(generator) * 20.0f - 10.0f, uniform(generator) * 4.0f - 2.0f + radius, uniform(generator) * 20.0f - 10.0f);
+
+		scene.spheres.push_back({ center, radius * (0.5f + uniform(generator)), (unsigned int)(i % 2), { 0, 0, 0 } });
+	}
+
+	return scene;
+}
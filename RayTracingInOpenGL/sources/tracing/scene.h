@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+// Scene description shared by the GPU and CPU backends. The layouts match the std430 structs declared in
+// "shaders/common/scene.glsl", so every array can be uploaded to a shader storage buffer as is.
+
+struct Light
+{
+	glm::vec3 position;
+	float intensity;
+	glm::vec3 color;
+	float radius; // Spherical light casting soft shadows, a point light when 0.
+};
+
+#define MAX_TEXTURE_LAYERS 16 // Must match "shaders/common/scene.glsl", which sizes "u_texture_lods" with it.
+
+struct Material
+{
+	glm::vec3 diffuseColor; // Also used while the texture is not resident yet.
+	int textureLayer; // Negative when the material is not textured.
+};
+
+struct Sphere
+{
+	glm::vec3 center;
+	float radius;
+	unsigned int material;
+	unsigned int padding[3];
+};
+
+struct Plane
+{
+	glm::vec3 normal;
+	float yPosition; // The plane equation is "y = yPosition".
+	float xSize, zSize;
+	unsigned int material;
+	unsigned int padding;
+};
+
+struct Triangle
+{
+	glm::vec3 vertex0;
+	unsigned int material;
+	glm::vec3 vertex1;
+	float padding0;
+	glm::vec3 vertex2;
+	float padding1;
+};
+
+// Placement of a mesh of the source scene description. Instances are flattened into world space triangles when a
+// scene is converted, so the renderers never read this table; it records which triangles came from which instance.
+struct Instance
+{
+	glm::mat4 transform; // Object to world.
+
+	unsigned int firstTriangle, triangleCount;
+	unsigned int mesh; // Index of the mesh in the source scene description.
+	unsigned int padding;
+};
+
+struct Scene
+{
+	std::vector<Light> lights;
+	std::vector<Material> materials;
+	std::vector<Sphere> spheres;
+	std::vector<Plane> planes;
+	std::vector<Triangle> triangles;
+	std::vector<Instance> instances;
+
+	glm::vec3 backgroundColor;
+
+	void computeBounds(glm::vec3& minimum, glm::vec3& maximum) const;
+};
+
+Scene createDefaultScene(int extraSphereCount = 0); // Extra small spheres are scattered above the plane.
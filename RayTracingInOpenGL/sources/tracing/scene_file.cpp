@@ -0,0 +1,357 @@
+#include "scene_file.h"
+
+static_assert(sizeof(SceneFileHeader) == 64, "The scene file header layout changed.");
+static_assert(sizeof(SceneFileSection) == 24, "The scene file section layout changed.");
+
+template <typename T>
+static bool readSection(const unsigned char* data, const SceneFileSection& section, std::vector<T>& items, SceneFileSections::Section& mapped)
+{
+	if (section.elementSize != sizeof(T)) return false;
+
+	const T* first = (const T*)(data + section.offset);
+
+	// The copy is what the CPU backend and scene edits work on, the GPU backend can upload the mapped section instead.
+	items.assign(first, first + section.count);
+	mapped = { first, (long long)(section.count * sizeof(T)) };
+
+	return true;
+}
+
+static bool isValidPrimitive(const Scene& scene, unsigned int primitive)
+{
+	unsigned int index = primitive & PRIMITIVE_INDEX_MASK;
+
+	switch (primitive >> PRIMITIVE_TYPE_SHIFT)
+	{
+	case PRIMITIVE_SPHERE: return index < scene.spheres.size();
+	case PRIMITIVE_PLANE: return index < scene.planes.size();
+	case PRIMITIVE_TRIANGLE: return index < scene.triangles.size();
+	default: return false;
+	}
+}
+
+static bool hasValidMaterials(const Scene& scene)
+{
+	size_t materialCount = scene.materials.size();
+
+	for (const Sphere& sphere : scene.spheres)
+	{
+		if (sphere.material >= materialCount) return false;
+	}
+
+	for (const Plane& plane : scene.planes)
+	{
+		if (plane.material >= materialCount) return false;
+	}
+
+	for (const Triangle& triangle : scene.triangles)
+	{
+		if (triangle.material >= materialCount) return false;
+	}
+
+	return true;
+}
+
+// Checks every index stored in the prebuilt BVH, so that the traversals can trust them, and measures the depth of the
+// wide tree. Children are always stored after their parent, which also rules out cycles.
+static bool isValidBvh(const Scene& scene, const std::vector<BvhNode>& nodes, const std::vector<unsigned int>& primitives,
+	const std::vector<WideBvhNode>& wideNodes, const std::vector<unsigned int>& widePrimitives, int& wideDepth)
+{
+	for (unsigned int primitive : primitives)
+	{
+		if (!isValidPrimitive(scene, primitive)) return false;
+	}
+
+	for (unsigned int primitive : widePrimitives)
+	{
+		if (!isValidPrimitive(scene, primitive)) return false;
+	}
+
+	std::vector<int> depths(nodes.size(), 0);
+
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		const BvhNode& node = nodes[i];
+
+		if (node.count > 0)
+		{
+			if ((unsigned long long)node.leftFirst + node.count > primitives.size()) return false;
+
+			continue;
+		}
+
+		if (node.leftFirst <= i || (unsigned long long)node.leftFirst + 1 >= nodes.size() || depths[i] + 1 >= Bvh::STACK_SIZE) return false;
+
+		depths[node.leftFirst] = std::max(depths[node.leftFirst], depths[i] + 1);
+		depths[node.leftFirst + 1] = std::max(depths[node.leftFirst + 1], depths[i] + 1);
+	}
+
+	std::vector<int> wideDepths(wideNodes.size(), 1);
+
+	wideDepth = 0;
+
+	for (size_t i = 0; i < wideNodes.size(); i++)
+	{
+		const WideBvhNode& node = wideNodes[i];
+
+		unsigned int internalCount = 0;
+
+		for (int slot = 0; slot < Bvh::WIDTH; slot++)
+		{
+			if ((node.internalMask >> slot) & 1u)
+			{
+				internalCount += 1;
+			}
+			else if (node.meta[slot] != 0 && (unsigned long long)node.primitiveBase + (node.meta[slot] & 31u) + (node.meta[slot] >> 5) > widePrimitives.size())
+			{
+				return false;
+			}
+		}
+
+		wideDepth = std::max(wideDepth, wideDepths[i]);
+
+		if (internalCount == 0) continue;
+
+		if (node.childBase <= i || (unsigned long long)node.childBase + internalCount > wideNodes.size()) return false;
+
+		for (unsigned int j = 0; j < internalCount; j++)
+		{
+			wideDepths[node.childBase + j] = std::max(wideDepths[node.childBase + j], wideDepths[i] + 1);
+		}
+	}
+
+	return wideDepth <= Bvh::WIDE_STACK_SIZE;
+}
+
+static size_t alignOffset(size_t offset)
+{
+	return (offset + SCENE_FILE_ALIGNMENT - 1) / SCENE_FILE_ALIGNMENT * SCENE_FILE_ALIGNMENT;
+}
+
+bool loadSceneFile(const char* filepath, Scene& scene, Bvh*& bvh)
+{
+	MappedFile file(filepath);
+
+	return loadSceneFile(file, filepath, scene, bvh, NULL);
+}
+
+bool loadSceneFile(MappedFile& file, const char* filepath, Scene& scene, Bvh*& bvh, SceneFileSections* mappedSections)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	Clock::time_point start = Clock::now();
+
+	bvh = NULL;
+
+	if (!file.isOpen()) return false;
+
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+
+	const SceneFileHeader* header = (const SceneFileHeader*)data;
+
+	if (size < sizeof(SceneFileHeader) || memcmp(header->magic, SCENE_FILE_MAGIC, sizeof(header->magic)) != 0)
+	{
+		std::cout << "[ERROR] SCENE FILE: \"" << filepath << "\" is not a scene file." << std::endl;
+
+		return false;
+	}
+
+	if (header->version != SCENE_FILE_VERSION)
+	{
+		std::cout << "[ERROR] SCENE FILE: \"" << filepath << "\" has version " << header->version << " instead of "
+			<< SCENE_FILE_VERSION << ", convert it again." << std::endl;
+
+		return false;
+	}
+
+	if (header->fileSize != size || header->sectionCount > (size - sizeof(SceneFileHeader)) / sizeof(SceneFileSection))
+	{
+		std::cout << "[ERROR] SCENE FILE: \"" << filepath << "\" is truncated." << std::endl;
+
+		return false;
+	}
+
+	const SceneFileSection* sections = (const SceneFileSection*)(data + sizeof(SceneFileHeader));
+
+	Scene loadedScene;
+	std::vector<BvhNode> nodes;
+	std::vector<unsigned int> primitives, widePrimitives;
+	std::vector<WideBvhNode> wideNodes;
+
+	SceneFileSections mapped = {};
+	SceneFileSections::Section unused = {}; // Sections only the CPU backend reads.
+
+	loadedScene.backgroundColor = header->backgroundColor;
+
+	for (unsigned int i = 0; i < header->sectionCount; i++)
+	{
+		const SceneFileSection& section = sections[i];
+
+		bool valid = section.offset % SCENE_FILE_ALIGNMENT == 0 && section.offset <= size && section.elementSize > 0
+			&& section.count <= (size - section.offset) / section.elementSize;
+
+		switch (valid ? section.type : 0)
+		{
+		case 0: break;
+		case SCENE_SECTION_LIGHTS: valid = readSection(data, section, loadedScene.lights, mapped.lights); break;
+		case SCENE_SECTION_MATERIALS: valid = readSection(data, section, loadedScene.materials, mapped.materials); break;
+		case SCENE_SECTION_SPHERES: valid = readSection(data, section, loadedScene.spheres, mapped.spheres); break;
+		case SCENE_SECTION_PLANES: valid = readSection(data, section, loadedScene.planes, mapped.planes); break;
+		case SCENE_SECTION_TRIANGLES: valid = readSection(data, section, loadedScene.triangles, mapped.triangles); break;
+		case SCENE_SECTION_INSTANCES: valid = readSection(data, section, loadedScene.instances, unused); break;
+		case SCENE_SECTION_BVH_NODES: valid = readSection(data, section, nodes, unused); break;
+		case SCENE_SECTION_BVH_PRIMITIVES: valid = readSection(data, section, primitives, unused); break;
+		case SCENE_SECTION_WIDE_BVH_NODES: valid = readSection(data, section, wideNodes, mapped.wideNodes); break;
+		case SCENE_SECTION_WIDE_BVH_PRIMITIVES: valid = readSection(data, section, widePrimitives, mapped.widePrimitives); break;
+		default: break; // Written by a newer converter.
+		}
+
+		if (!valid)
+		{
+			std::cout << "[ERROR] SCENE FILE: Section " << i << " of \"" << filepath << "\" is corrupted." << std::endl;
+
+			return false;
+		}
+	}
+
+	if (!hasValidMaterials(loadedScene))
+	{
+		std::cout << "[ERROR] SCENE FILE: \"" << filepath << "\" references materials it does not have." << std::endl;
+
+		return false;
+	}
+
+	// Layers past the ones the shaders can index are untextured, as the converter writes them.
+	for (Material& material : loadedScene.materials)
+	{
+		if (material.textureLayer >= MAX_TEXTURE_LAYERS)
+		{
+			std::cout << "[ERROR] SCENE FILE: Texture layer " << material.textureLayer << " of \"" << filepath << "\" is out of range, the material is not textured." << std::endl;
+
+			material.textureLayer = -1;
+			mapped.materials.data = NULL; // Only the copy has the fix.
+		}
+	}
+
+	size_t primitiveCount = loadedScene.spheres.size() + loadedScene.planes.size() + loadedScene.triangles.size();
+
+	// The prebuilt BVH is only used when it references exactly the primitives of the file and every one of its indices
+	// is in range, otherwise it is rebuilt.
+	int wideDepth = 0;
+
+	bool hasBvh = !wideNodes.empty() && widePrimitives.size() == primitiveCount && (nodes.empty() || primitives.size() == primitiveCount)
+		&& isValidBvh(loadedScene, nodes, primitives, wideNodes, widePrimitives, wideDepth);
+
+	if (!hasBvh && !wideNodes.empty())
+	{
+		std::cout << "[ERROR] SCENE FILE: The prebuilt BVH of \"" << filepath << "\" is corrupted or does not match its primitives, it is built again." << std::endl;
+	}
+
+	scene = std::move(loadedScene);
+
+	if (hasBvh)
+	{
+		bvh = new Bvh(std::move(nodes), std::move(primitives), std::move(wideNodes), std::move(widePrimitives), wideDepth);
+	}
+	else
+	{
+		mapped.wideNodes.data = NULL;
+		mapped.widePrimitives.data = NULL;
+	}
+
+	if (mappedSections) *mappedSections = mapped;
+
+	float milliseconds = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	std::cout << "[INFO] SCENE FILE: Loaded \"" << filepath << "\" (" << primitiveCount << " primitives, "
+		<< (hasBvh ? "prebuilt BVH" : "no BVH") << ") in " << milliseconds << " ms." << std::endl;
+
+	return true;
+}
+
+bool saveSceneFile(const char* filepath, const Scene& scene, Bvh* bvh)
+{
+	struct Payload
+	{
+		unsigned int type, elementSize;
+
+		const void* data;
+		size_t count;
+	};
+
+	std::vector<Payload> payloads;
+
+	auto addSection = [&payloads](unsigned int type, const auto& items)
+	{
+		if (!items.empty()) payloads.push_back({ type, (unsigned int)sizeof(items[0]), items.data(), items.size() });
+	};
+
+	addSection(SCENE_SECTION_LIGHTS, scene.lights);
+	addSection(SCENE_SECTION_MATERIALS, scene.materials);
+	addSection(SCENE_SECTION_SPHERES, scene.spheres);
+	addSection(SCENE_SECTION_PLANES, scene.planes);
+	addSection(SCENE_SECTION_TRIANGLES, scene.triangles);
+	addSection(SCENE_SECTION_INSTANCES, scene.instances);
+
+	if (bvh)
+	{
+		addSection(SCENE_SECTION_BVH_NODES, bvh->getNodes());
+		addSection(SCENE_SECTION_BVH_PRIMITIVES, bvh->getPrimitives());
+		addSection(SCENE_SECTION_WIDE_BVH_NODES, bvh->getWideNodes());
+		addSection(SCENE_SECTION_WIDE_BVH_PRIMITIVES, bvh->getWidePrimitives());
+	}
+
+	std::vector<SceneFileSection> sections;
+	size_t offset = alignOffset(sizeof(SceneFileHeader) + payloads.size() * sizeof(SceneFileSection));
+
+	for (const Payload& payload : payloads)
+	{
+		sections.push_back({ payload.type, payload.elementSize, offset, payload.count });
+
+		offset = alignOffset(offset + payload.elementSize * payload.count);
+	}
+
+	SceneFileHeader header = {};
+
+	memcpy(header.magic, SCENE_FILE_MAGIC, sizeof(SCENE_FILE_MAGIC));
+	header.version = SCENE_FILE_VERSION;
+	header.sectionCount = (unsigned int)sections.size();
+	header.fileSize = offset;
+	header.backgroundColor = scene.backgroundColor;
+	header.bvhWideDepth = bvh ? bvh->getWideDepth() : 0;
+
+	std::ofstream fileStream(filepath, std::ios::binary);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SCENE FILE: Failed to open \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	const char padding[SCENE_FILE_ALIGNMENT] = {};
+	size_t written = sizeof(SceneFileHeader) + sections.size() * sizeof(SceneFileSection);
+
+	fileStream.write((const char*)&header, sizeof(header));
+	fileStream.write((const char*)sections.data(), sections.size() * sizeof(SceneFileSection));
+
+	for (size_t i = 0; i < payloads.size(); i++)
+	{
+		fileStream.write(padding, sections[i].offset - written);
+		fileStream.write((const char*)payloads[i].data, payloads[i].elementSize * payloads[i].count);
+
+		written = sections[i].offset + payloads[i].elementSize * payloads[i].count;
+	}
+
+	fileStream.write(padding, offset - written);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SCENE FILE: Failed to write \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
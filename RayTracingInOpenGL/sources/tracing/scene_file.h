@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include "scene.h"
+#include "bvh.h"
+
+#include "../utils/mapped_file.h"
+
+// Binary scene container, written by the "SceneConverter" tool.
+//
+// The file starts with a header and a table of sections. Each section is an array of one of the structs of "scene.h"
+// or "bvh.h" stored exactly as it is in memory (little endian, std430 compatible), at a 64-byte aligned offset. Loading
+// a scene maps the file and copies every section into place in one go, without parsing any element. Sections of an
+// unknown type are skipped, and a section whose element size does not match its struct is rejected. The indices are
+// then checked once: a file referencing missing materials is rejected, and a prebuilt BVH with an index out of range
+// or deeper than the traversal stacks is ignored, so that the tree is built again from the primitives.
+//
+// The version must be bumped whenever one of the stored structs or the meaning of a section changes.
+//
+#define SCENE_FILE_MAGIC "RTSCENE"
+#define SCENE_FILE_VERSION 1
+#define SCENE_FILE_ALIGNMENT 64
+
+enum SceneFileSectionType
+{
+	SCENE_SECTION_LIGHTS = 1,
+	SCENE_SECTION_MATERIALS,
+	SCENE_SECTION_SPHERES,
+	SCENE_SECTION_PLANES,
+	SCENE_SECTION_TRIANGLES,
+	SCENE_SECTION_INSTANCES,
+	SCENE_SECTION_BVH_NODES, // The prebuilt BVH sections are optional.
+	SCENE_SECTION_BVH_PRIMITIVES,
+	SCENE_SECTION_WIDE_BVH_NODES,
+	SCENE_SECTION_WIDE_BVH_PRIMITIVES
+};
+
+struct SceneFileHeader
+{
+	char magic[8];
+	unsigned int version;
+	unsigned int sectionCount; // The section table follows the header.
+	unsigned long long fileSize; // Catches truncated files.
+	glm::vec3 backgroundColor;
+	int bvhWideDepth; // Only meaningful when the file holds a prebuilt BVH, the loader measures it again anyway.
+	unsigned int reserved[6];
+};
+
+struct SceneFileSection
+{
+	unsigned int type;
+	unsigned int elementSize;
+	unsigned long long offset; // From the start of the file.
+	unsigned long long count;
+};
+
+// Sections of a loaded scene file that the GPU buffers can be created from in place, straight from the mapping (their
+// 64-byte alignment suits any buffer upload), rather than from the copies the CPU backend works on.
+struct SceneFileSections
+{
+	struct Section
+	{
+		const void* data; // NULL when the file has no such section, or when the loader had to rewrite it.
+		long long size;
+	};
+
+	Section lights, materials, spheres, planes, triangles, wideNodes, widePrimitives;
+};
+
+// Replaces "scene" with the one stored in a file, and creates "bvh" from its prebuilt BVH if it has one ("bvh" is
+// left NULL otherwise). Nothing is changed when the file cannot be loaded.
+bool loadSceneFile(const char* filepath, Scene& scene, Bvh*& bvh);
+
+// Same, from a file the caller keeps mapped. "mappedSections" then points into the mapping, and remains valid for as
+// long as "file" is.
+bool loadSceneFile(MappedFile& file, const char* filepath, Scene& scene, Bvh*& bvh, SceneFileSections* mappedSections);
+
+// Writes "scene", along with both layouts of "bvh" unless it is NULL.
+bool saveSceneFile(const char* filepath, const Scene& scene, Bvh* bvh);
@@ -0,0 +1,251 @@
+#include "frame_capture.h"
+
+// POSIX popen only accepts "r" or "w" and pipes are never translated there, the binary flag is needed on Windows only.
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define PIPE_WRITE_MODE "wb"
+#else
+#define PIPE_WRITE_MODE "w"
+#endif
+
+FrameCapture::FrameCapture(const char* filepath, int width, int height, int frameRate, int ringSize)
+	: ID(), width(width), height(height), frameRate(frameRate), ringSize(ringSize), frameSize(width * height * 3),
+	  y4m(false), pipe(filepath[0] == '|'), sink(NULL), mappedPixels(NULL), slots(ringSize), captureIndex(0), pendingIndex(0),
+	  startTime(-1.0), scheduledFrames(0), capturedFrames(0), droppedFrames(0), running(false)
+{
+	std::string path(filepath);
+
+	y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+	sink = pipe ? popen(filepath + 1, PIPE_WRITE_MODE) : fopen(filepath, "wb");
+
+	if (!sink)
+	{
+		std::cout << "[ERROR] FRAME CAPTURE: Failed to open \"" << filepath << "\"." << std::endl;
+
+		return;
+	}
+
+	if (y4m)
+	{
+		fprintf(sink, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, frameRate);
+	}
+
+	for (Slot& slot : slots)
+	{
+		slot.state = FREE;
+		slot.fence = NULL;
+		slot.repeats = 0;
+	}
+
+	// The ring is mapped once for the whole capture; coherent mapping makes finished copies visible to the writer
+	// thread as soon as their fence is signaled, without any further GL call.
+	//
+	GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+	glBufferStorage(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)frameSize * ringSize, NULL, flags | GL_CLIENT_STORAGE_BIT);
+
+	mappedPixels = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)frameSize * ringSize, flags);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (!mappedPixels)
+	{
+		std::cout << "[ERROR] FRAME CAPTURE: Failed to map the pixel buffer ring." << std::endl;
+
+		return;
+	}
+
+	running = true;
+	writer = std::thread(&FrameCapture::writeFrames, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	if (running)
+	{
+		// Stopping is the only point where the render thread waits, so that no finished frame is lost.
+		retireFinishedCopies(true);
+
+		running = false;
+		writerCondition.notify_one();
+
+		writer.join();
+
+		std::cout << "[INFO] FRAME CAPTURE: " << capturedFrames << " frames written, " << droppedFrames << " dropped." << std::endl;
+	}
+
+	for (Slot& slot : slots)
+	{
+		if (slot.fence) glDeleteSync(slot.fence);
+	}
+
+	if (ID)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		glDeleteBuffers(1, &ID);
+	}
+
+	if (sink)
+	{
+		pipe ? pclose(sink) : fclose(sink);
+	}
+}
+
+void FrameCapture::capture(Texture* texture, double time)
+{
+	if (!running) return;
+
+	retireFinishedCopies(false);
+
+	if (startTime < 0.0) startTime = time;
+
+	// Output frame "i" shows the newest state at "startTime + i / frameRate", frames this one does not reach are
+	// left to a later one.
+	unsigned int dueFrames = (unsigned int)((time - startTime) * frameRate) + 1;
+
+	if (dueFrames <= scheduledFrames) return;
+
+	Slot& slot = slots[captureIndex];
+
+	if (slot.state != FREE) // The sink fell behind and every slot is still in use, the next frame fills the gap.
+	{
+		droppedFrames += 1;
+
+		return;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	// With a pixel pack buffer bound the copy is queued on the GPU and the pointer is an offset into the ring.
+	texture->getImage(GL_RGB, GL_UNSIGNED_BYTE, frameSize, (void*)((size_t)captureIndex * frameSize));
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.repeats = dueFrames - scheduledFrames;
+	slot.state = PENDING;
+
+	scheduledFrames = dueFrames;
+
+	captureIndex = (captureIndex + 1) % ringSize;
+}
+
+bool FrameCapture::isRecording()
+{
+	return running;
+}
+
+unsigned int FrameCapture::getCapturedFrames()
+{
+	return capturedFrames;
+}
+
+unsigned int FrameCapture::getDroppedFrames()
+{
+	return droppedFrames;
+}
+
+void FrameCapture::retireFinishedCopies(bool wait)
+{
+	// Copies finish in submission order, so only the oldest pending slot has to be polled.
+	while (slots[pendingIndex].state == PENDING)
+	{
+		Slot& slot = slots[pendingIndex];
+
+		GLenum result = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) break;
+
+		glDeleteSync(slot.fence);
+
+		slot.fence = NULL;
+		slot.state = QUEUED;
+
+		writerCondition.notify_one();
+
+		pendingIndex = (pendingIndex + 1) % ringSize;
+	}
+}
+
+void FrameCapture::writeFrames()
+{
+	std::vector<unsigned char> planes(y4m ? frameSize : 0);
+	int writeIndex = 0;
+
+	while (true)
+	{
+		Slot& slot = slots[writeIndex];
+
+		if (slot.state != QUEUED)
+		{
+			if (!running) break;
+
+			// The render thread notifies without locking, the timeout covers a notification sent before this wait.
+			std::unique_lock<std::mutex> lock(writerMutex);
+			writerCondition.wait_for(lock, std::chrono::milliseconds(5));
+
+			continue;
+		}
+
+		writeFrame(mappedPixels + (size_t)writeIndex * frameSize, planes, slot.repeats);
+
+		capturedFrames += slot.repeats;
+
+		slot.state = FREE;
+		writeIndex = (writeIndex + 1) % ringSize;
+	}
+
+	fflush(sink);
+}
+
+void FrameCapture::writeFrame(const unsigned char* pixels, std::vector<unsigned char>& planes, unsigned int repeats)
+{
+	int rowSize = width * 3;
+
+	if (!y4m)
+	{
+		// OpenGL returns the bottom row first, so rows are written straight from the mapped ring in reverse order.
+		for (unsigned int i = 0; i < repeats; i++)
+		{
+			for (int y = height - 1; y >= 0; y--)
+			{
+				fwrite(pixels + (size_t)y * rowSize, 1, rowSize, sink);
+			}
+		}
+
+		return;
+	}
+
+	unsigned char* yPlane = planes.data();
+	unsigned char* uPlane = yPlane + width * height;
+	unsigned char* vPlane = uPlane + width * height;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = pixels + (size_t)(height - 1 - y) * rowSize;
+
+		for (int x = 0; x < width; x++)
+		{
+			// BT.601 limited range, which is what Y4M consumers assume by default.
+			float r = row[x * 3 + 0], g = row[x * 3 + 1], b = row[x * 3 + 2];
+			int i = y * width + x;
+
+			yPlane[i] = (unsigned char)(16.5f + 0.257f * r + 0.504f * g + 0.098f * b);
+			uPlane[i] = (unsigned char)(128.5f - 0.148f * r - 0.291f * g + 0.439f * b);
+			vPlane[i] = (unsigned char)(128.5f + 0.439f * r - 0.368f * g - 0.071f * b);
+		}
+	}
+
+	for (unsigned int i = 0; i < repeats; i++)
+	{
+		fputs("FRAME\n", sink);
+		fwrite(planes.data(), 1, planes.size(), sink);
+	}
+}
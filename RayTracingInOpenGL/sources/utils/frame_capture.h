@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <iostream>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include "../graphics/texture.h"
+
+// Records rendered frames to a Y4M or raw RGB video stream.
+//
+// Each captured frame is read back into a slot of a persistently mapped pixel buffer ring. The render thread only
+// issues the copy and a fence, and hands the slot over to a writer thread once the fence is signaled, so it never
+// waits on the GPU or on the sink. When every slot is still busy the frame is dropped and counted instead.
+//
+// The stream runs at a fixed frame rate whatever the render rate: each rendered frame is stamped with the simulation
+// time of its state and stands for every output frame due since the previous one, so it is skipped when the renderer
+// runs ahead of the stream and repeated when it falls behind (or after a dropped frame).
+//
+// A filepath ending in ".y4m" produces a YUV4MPEG2 stream (4:4:4), anything else produces headerless RGB24 frames.
+// A filepath starting with '|' is executed as a command that receives the stream on its standard input.
+//
+class FrameCapture
+{
+public:
+	FrameCapture(const char* filepath, int width, int height, int frameRate = 60, int ringSize = 4);
+	~FrameCapture();
+
+	void capture(Texture* texture, double time);
+
+	bool isRecording();
+
+	unsigned int getCapturedFrames();
+	unsigned int getDroppedFrames();
+
+private:
+	enum SlotState { FREE, PENDING, QUEUED };
+
+	struct Slot
+	{
+		std::atomic<int> state;
+
+		GLsync fence;
+		unsigned int repeats; // Output frames the slot stands for.
+	};
+
+	unsigned int ID;
+
+	int width, height, frameRate, ringSize, frameSize;
+	bool y4m, pipe;
+
+	FILE* sink;
+	unsigned char* mappedPixels;
+
+	std::vector<Slot> slots;
+	int captureIndex, pendingIndex;
+
+	double startTime; // Simulation time of the first captured frame, negative until then.
+	unsigned int scheduledFrames; // Output frames handed to the writer so far, repeats included.
+
+	std::atomic<unsigned int> capturedFrames, droppedFrames;
+	std::atomic<bool> running;
+
+	std::thread writer;
+	std::mutex writerMutex;
+	std::condition_variable writerCondition;
+
+	void retireFinishedCopies(bool wait);
+
+	void writeFrames();
+	void writeFrame(const unsigned char* pixels, std::vector<unsigned char>& planes, unsigned int repeats);
+};
@@ -0,0 +1,105 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile(const char* filepath)
+	: data(NULL), size(0), fileHandle(NULL), mappingHandle(NULL)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER fileSize;
+
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to open \"" << filepath << "\"." << std::endl;
+
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (!view)
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to map \"" << filepath << "\"." << std::endl;
+
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+
+		return;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const unsigned char*)view;
+	size = (size_t)fileSize.QuadPart;
+#else
+	int file = open(filepath, O_RDONLY);
+	struct stat fileStatus;
+
+	if (file < 0 || fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to open \"" << filepath << "\"." << std::endl;
+
+		if (file >= 0) close(file);
+
+		return;
+	}
+
+	void* view = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	close(file);
+
+	if (view == MAP_FAILED)
+	{
+		std::cout << "[ERROR] MAPPED FILE: Failed to map \"" << filepath << "\"." << std::endl;
+
+		return;
+	}
+
+	// The whole file is about to be read, start reading ahead right away.
+	madvise(view, (size_t)fileStatus.st_size, MADV_WILLNEED);
+
+	data = (const unsigned char*)view;
+	size = (size_t)fileStatus.st_size;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	if (!data) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle((HANDLE)mappingHandle);
+	CloseHandle((HANDLE)fileHandle);
+#else
+	munmap((void*)data, size);
+#endif
+}
+
+bool MappedFile::isOpen()
+{
+	return data != NULL;
+}
+
+const unsigned char* MappedFile::getData()
+{
+	return data;
+}
+
+size_t MappedFile::getSize()
+{
+	return size;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+
+// Read-only memory mapping of a whole file. Pages are only read from disk when first touched, and the mapping is
+// shared with the page cache, so loading a file this way costs no copy beyond the one its user makes.
+//
+class MappedFile
+{
+public:
+	MappedFile(const char* filepath);
+	~MappedFile();
+
+	bool isOpen();
+
+	const unsigned char* getData();
+	size_t getSize();
+
+private:
+	const unsigned char* data;
+	size_t size;
+
+	void* fileHandle; // Windows only, the POSIX mapping does not outlive its file descriptor.
+	void* mappingHandle;
+};
@@ -0,0 +1,69 @@
+#include "radix_sort.h"
+
+void radixSort(unsigned int* keys, unsigned int* values, unsigned int* tempKeys, unsigned int* tempValues, int count, int keyBits, ThreadPool* threadPool)
+{
+	const int radix = 256;
+
+	int chunks = threadPool->getThreadCount() + 1;
+	int chunkSize = (count + chunks - 1) / chunks;
+
+	if (count <= 0) return;
+
+	std::vector<unsigned int> offsets((size_t)chunks * radix);
+
+	unsigned int* srcKeys = keys;
+	unsigned int* srcValues = values;
+	unsigned int* dstKeys = tempKeys;
+	unsigned int* dstValues = tempValues;
+
+	for (int shift = 0; shift < keyBits; shift += 8)
+	{
+		std::fill(offsets.begin(), offsets.end(), 0u); // Chunks past the end of the array stay empty.
+
+		threadPool->parallelFor(count, chunkSize, [&](int begin, int end)
+		{
+			unsigned int* histogram = &offsets[(size_t)(begin / chunkSize) * radix];
+
+			for (int i = begin; i < end; i++)
+			{
+				histogram[(srcKeys[i] >> shift) & (radix - 1)] += 1;
+			}
+		});
+
+		// Digit-major exclusive scan: all chunks of digit 0, then all chunks of digit 1, and so on.
+		unsigned int runningSum = 0;
+
+		for (int digit = 0; digit < radix; digit++)
+		{
+			for (int chunk = 0; chunk < chunks; chunk++)
+			{
+				unsigned int digitCount = offsets[(size_t)chunk * radix + digit];
+
+				offsets[(size_t)chunk * radix + digit] = runningSum;
+				runningSum += digitCount;
+			}
+		}
+
+		threadPool->parallelFor(count, chunkSize, [&](int begin, int end)
+		{
+			unsigned int* offset = &offsets[(size_t)(begin / chunkSize) * radix];
+
+			for (int i = begin; i < end; i++)
+			{
+				unsigned int destination = offset[(srcKeys[i] >> shift) & (radix - 1)]++;
+
+				dstKeys[destination] = srcKeys[i];
+				dstValues[destination] = srcValues[i];
+			}
+		});
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+	}
+
+	if (srcKeys != keys) // Odd number of passes.
+	{
+		memcpy(keys, srcKeys, (size_t)count * sizeof(unsigned int));
+		memcpy(values, srcValues, (size_t)count * sizeof(unsigned int));
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "thread_pool.h"
+
+// Stable LSD radix sort of 32-bit keys carrying 32-bit values, 8 bits per pass, only over the lowest "keyBits" bits.
+// Every pass builds one histogram per chunk in parallel, scans them in digit-major order and scatters each chunk
+// to its own offsets in parallel. The temporary arrays must hold "count" elements; the result ends in "keys"/"values".
+//
+void radixSort(unsigned int* keys, unsigned int* values, unsigned int* tempKeys, unsigned int* tempValues, int count, int keyBits, ThreadPool* threadPool);
@@ -0,0 +1,124 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+	: stopping(false)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+
+		stopping = true;
+	}
+
+	jobsCondition.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::enqueue(const std::function<void()>& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+
+		jobs.push(job);
+	}
+
+	jobsCondition.notify_one();
+}
+
+void ThreadPool::parallelFor(int count, int grain, const std::function<void(int begin, int end)>& body)
+{
+	struct State
+	{
+		std::function<void(int, int)> body;
+		std::atomic<int> nextChunk, finishedChunks;
+		std::mutex finishedMutex;
+		std::condition_variable finishedCondition;
+		int count, grain, chunks;
+	};
+
+	grain = std::max(grain, 1);
+
+	// Helpers may only start after the loop is over, hence the shared state instead of locals.
+	std::shared_ptr<State> state = std::make_shared<State>();
+
+	state->body = body;
+	state->nextChunk = 0;
+	state->finishedChunks = 0;
+	state->count = count;
+	state->grain = grain;
+	state->chunks = (count + grain - 1) / grain;
+
+	auto runChunks = [](State* state)
+	{
+		int chunk;
+
+		while ((chunk = state->nextChunk++) < state->chunks)
+		{
+			int begin = chunk * state->grain;
+
+			state->body(begin, std::min(begin + state->grain, state->count));
+
+			if (++state->finishedChunks == state->chunks)
+			{
+				std::lock_guard<std::mutex> lock(state->finishedMutex);
+
+				state->finishedCondition.notify_all();
+			}
+		}
+	};
+
+	int helpers = std::min((int)workers.size(), state->chunks - 1);
+
+	for (int i = 0; i < helpers; i++)
+	{
+		enqueue([state, runChunks] { runChunks(state.get()); });
+	}
+
+	runChunks(state.get());
+
+	std::unique_lock<std::mutex> lock(state->finishedMutex);
+
+	state->finishedCondition.wait(lock, [&state] { return state->finishedChunks == state->chunks; });
+}
+
+int ThreadPool::getThreadCount()
+{
+	return (int)workers.size();
+}
+
+void ThreadPool::work()
+{
+	while (true)
+	{
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(jobsMutex);
+
+			jobsCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+			if (stopping && jobs.empty()) return;
+
+			job = std::move(jobs.front());
+			jobs.pop();
+		}
+
+		job();
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <queue>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+class ThreadPool
+{
+public:
+	ThreadPool(int threadCount = 0); // By default, one thread per hardware thread but the calling one.
+	~ThreadPool();
+
+	void enqueue(const std::function<void()>& job);
+
+	// Splits [0, count) in chunks of "grain" elements and runs them on the pool and on the calling thread.
+	// Returns once every chunk is done, so it can be used from any thread without waiting on unrelated jobs.
+	void parallelFor(int count, int grain, const std::function<void(int begin, int end)>& body);
+
+	int getThreadCount();
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+
+	std::mutex jobsMutex;
+	std::condition_variable jobsCondition;
+
+	bool stopping;
+
+	void work();
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free handoff of the latest value from one producer thread to one consumer thread.
+//
+// Each side owns one of the three slots, the third one sits in the middle. publish() swaps the producer slot with the
+// middle one and marks it fresh; update() swaps the consumer slot with the middle one if it is fresh. Neither side
+// ever waits: the producer overwrites values the consumer did not pick up in time, and the consumer keeps reading
+// its current value until a newer one is published.
+//
+// The producer slot holds stale data after publish(), so the producer should fill it entirely before each publish().
+//
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer(const T& initial = T());
+
+	T& getWriteBuffer(); // Producer only.
+	void publish();
+
+	bool update(); // Consumer only, returns whether a newer value was picked up.
+	T& getReadBuffer();
+
+private:
+	static const unsigned int FRESH_BIT = 4;
+	static const unsigned int INDEX_MASK = 3;
+
+	T buffers[3];
+
+	unsigned int writeIndex, readIndex;
+	std::atomic<unsigned int> middle; // Index of the middle slot, with FRESH_BIT set when it holds an unread value.
+};
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer(const T& initial)
+	: buffers{ initial, initial, initial }, writeIndex(0), readIndex(1), middle(2)
+{
+}
+
+template <typename T>
+T& TripleBuffer<T>::getWriteBuffer()
+{
+	return buffers[writeIndex];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish()
+{
+	// Release makes the written slot visible to the consumer, acquire gets back a slot it is done with.
+	writeIndex = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+template <typename T>
+bool TripleBuffer<T>::update()
+{
+	if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+
+	readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+
+	return true;
+}
+
+template <typename T>
+T& TripleBuffer<T>::getReadBuffer()
+{
+	return buffers[readIndex];
+}
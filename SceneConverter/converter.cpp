@@ -0,0 +1,333 @@
+// Scene Converter.
+//
+// Converts a Wavefront OBJ mesh or a JSON scene description into the binary scene files loaded by the ray tracer
+// (see "sources/tracing/scene_file.h"), with a prebuilt BVH unless "--no-bvh" is given.
+//
+//     SceneConverter <scene.json | mesh.obj> <output.rtscene> [--no-bvh]
+//     SceneConverter --default <extra spheres> <output.rtscene> [--no-bvh]
+//     SceneConverter --validate-bvh <scene.rtscene> [rays]
+//
+// The ray tracer loads the result with "RayTracingInOpenGL --scene <output.rtscene>". "--validate-bvh" checks both
+// BVH layouts of a scene file (or the ones built for it) against a brute force search, and exits with 1 when they
+// disagree; the project runs it on a generated scene after each build.
+//
+// A JSON scene description looks like this, every member being optional:
+//
+//     {
+//         "background": [0.2, 0.4, 0.8],
+//         "lights": [{ "position": [5, 5, 5], "intensity": 1.5, "color": [1, 1, 1], "radius": 0.5 }],
+//         "materials": [{ "color": [0.75, 0.15, 0.75], "texture": 0 }],
+//         "spheres": [{ "center": [0, 0, 0], "radius": 1, "material": 0 }],
+//         "planes": [{ "y": -2, "size": [10, 10], "material": 0 }],
+//         "meshes": [{ "file": "bunny.obj" }],
+//         "instances": [{ "mesh": 0, "material": 0, "translation": [0, 1, 0], "rotation": [0, 90, 0], "scale": 2 }]
+//     }
+//
+// Mesh files are relative to the description. Instances are flattened into world space triangles, scaled, then
+// rotated around x, y and z (in degrees), then translated.
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "sources/json.h"
+#include "sources/obj_reader.h"
+
+#include "../RayTracingInOpenGL/sources/tracing/scene.h"
+#include "../RayTracingInOpenGL/sources/tracing/bvh.h"
+#include "../RayTracingInOpenGL/sources/tracing/scene_file.h"
+
+struct Mesh
+{
+	std::vector<glm::vec3> positions;
+	std::vector<unsigned int> indices;
+};
+
+static glm::vec3 getVec3(const JsonValue& value, const char* name, const glm::vec3& fallback)
+{
+	const JsonValue* member = value.get(name);
+
+	if (member && member->type == JsonValue::NUMBER) return glm::vec3((float)member->number);
+
+	if (!member || member->type != JsonValue::ARRAY || member->elements.size() != 3) return fallback;
+
+	return glm::vec3((float)member->elements[0].number, (float)member->elements[1].number, (float)member->elements[2].number);
+}
+
+static const std::vector<JsonValue>& getArray(const JsonValue& value, const char* name)
+{
+	static const std::vector<JsonValue> empty;
+
+	const JsonValue* member = value.get(name);
+
+	return member && member->type == JsonValue::ARRAY ? member->elements : empty;
+}
+
+static void addInstance(Scene& scene, const Mesh& mesh, unsigned int meshIndex, const glm::mat4& transform, unsigned int material)
+{
+	Instance instance = { transform, (unsigned int)scene.triangles.size(), (unsigned int)(mesh.indices.size() / 3), meshIndex, 0 };
+
+	std::vector<glm::vec3> positions(mesh.positions.size());
+
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		positions[i] = glm::vec3(transform * glm::vec4(mesh.positions[i], 1.0f));
+	}
+
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		scene.triangles.push_back({ positions[mesh.indices[i]], material, positions[mesh.indices[i + 1]], 0.0f, positions[mesh.indices[i + 2]], 0.0f });
+	}
+
+	scene.instances.push_back(instance);
+}
+
+static bool convertObj(const char* filepath, Scene& scene)
+{
+	Mesh mesh;
+
+	if (!readObj(filepath, mesh.positions, mesh.indices)) return false;
+
+	scene.backgroundColor = glm::vec3(0.2f, 0.4f, 0.8f);
+	scene.materials.push_back({ glm::vec3(0.75f, 0.75f, 0.75f), -1 });
+
+	addInstance(scene, mesh, 0, glm::mat4(1.0f), 0);
+
+	// A single light above the mesh, so that it shows up lit from the start.
+	glm::vec3 boundsMin, boundsMax;
+
+	scene.computeBounds(boundsMin, boundsMax);
+	scene.lights.push_back({ boundsMax + (boundsMax - boundsMin) * 0.5f, 1.5f, glm::vec3(1.0f), 0.0f });
+
+	return true;
+}
+
+static bool convertJson(const char* filepath, Scene& scene)
+{
+	std::ifstream fileStream(filepath, std::ios::binary);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] SCENE CONVERTER: Failed to open \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	std::string text((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+	std::string error;
+	JsonValue root;
+
+	if (!parseJson(text, root, error))
+	{
+		std::cout << "[ERROR] SCENE CONVERTER: \"" << filepath << "\": " << error << std::endl;
+
+		return false;
+	}
+
+	std::string path(filepath);
+	std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+
+	scene.backgroundColor = getVec3(root, "background", glm::vec3(0.2f, 0.4f, 0.8f));
+
+	for (const JsonValue& light : getArray(root, "lights"))
+	{
+		scene.lights.push_back({ getVec3(light, "position", glm::vec3(0.0f)), (float)light.getNumber("intensity", 1.0), getVec3(light, "color", glm::vec3(1.0f)), (float)light.getNumber("radius", 0.0) });
+	}
+
+	for (const JsonValue& material : getArray(root, "materials"))
+	{
+		double texture = material.getNumber("texture", -1.0);
+
+		// The renderers only index MAX_TEXTURE_LAYERS layers.
+		if (texture >= (double)MAX_TEXTURE_LAYERS)
+		{
+			std::cout << "[ERROR] SCENE CONVERTER: Texture layer " << texture << " is out of range, the material is not textured." << std::endl;
+
+			texture = -1.0;
+		}
+
+		scene.materials.push_back({ getVec3(material, "color", glm::vec3(0.75f)), texture < 0.0 ? -1 : (int)texture });
+	}
+
+	if (scene.materials.empty())
+	{
+		scene.materials.push_back({ glm::vec3(0.75f), -1 });
+	}
+
+	unsigned int materialCount = (unsigned int)scene.materials.size();
+
+	auto getMaterial = [materialCount](const JsonValue& value)
+	{
+		double material = value.getNumber("material", 0.0);
+
+		return material >= 0.0 && material < materialCount ? (unsigned int)material : 0u;
+	};
+
+	for (const JsonValue& sphere : getArray(root, "spheres"))
+	{
+		scene.spheres.push_back({ getVec3(sphere, "center", glm::vec3(0.0f)), (float)sphere.getNumber("radius", 1.0), getMaterial(sphere), { 0, 0, 0 } });
+	}
+
+	for (const JsonValue& plane : getArray(root, "planes"))
+	{
+		const JsonValue* size = plane.get("size");
+
+		float xSize = 10.0f, zSize = 10.0f;
+
+		if (size && size->type == JsonValue::ARRAY && size->elements.size() == 2)
+		{
+			xSize = (float)size->elements[0].number;
+			zSize = (float)size->elements[1].number;
+		}
+
+		scene.planes.push_back({ glm::vec3(0.0f, 1.0f, 0.0f), (float)plane.getNumber("y", 0.0), xSize, zSize, getMaterial(plane), 0 });
+	}
+
+	std::vector<Mesh> meshes;
+
+	for (const JsonValue& mesh : getArray(root, "meshes"))
+	{
+		std::string file = mesh.getString("file", "");
+
+		// Without a name the path would be the directory of the description, which the OBJ reader must not be given.
+		if (file.empty())
+		{
+			std::cout << "[ERROR] SCENE CONVERTER: Mesh " << meshes.size() << " has no \"file\"." << std::endl;
+
+			return false;
+		}
+
+		meshes.push_back(Mesh());
+
+		std::string meshPath = directory + file;
+
+		if (!readObj(meshPath.c_str(), meshes.back().positions, meshes.back().indices)) return false;
+	}
+
+	for (const JsonValue& instance : getArray(root, "instances"))
+	{
+		double mesh = instance.getNumber("mesh", 0.0);
+
+		if (mesh < 0.0 || mesh >= (double)meshes.size())
+		{
+			std::cout << "[ERROR] SCENE CONVERTER: An instance references mesh " << mesh << ", which does not exist." << std::endl;
+
+			return false;
+		}
+
+		glm::vec3 rotation = glm::radians(getVec3(instance, "rotation", glm::vec3(0.0f)));
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), getVec3(instance, "translation", glm::vec3(0.0f)));
+
+		transform = glm::rotate(transform, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+		transform = glm::rotate(transform, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+		transform = glm::rotate(transform, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+		transform = glm::scale(transform, getVec3(instance, "scale", glm::vec3(1.0f)));
+
+		addInstance(scene, meshes[(size_t)mesh], (unsigned int)mesh, transform, getMaterial(instance));
+	}
+
+	return true;
+}
+
+static int validateSceneFile(const char* filepath, int rayCount)
+{
+	Scene scene;
+	Bvh* bvh = NULL;
+
+	if (!loadSceneFile(filepath, scene, bvh)) return -1;
+
+	// Files written with "--no-bvh" are checked with the tree the ray tracer builds for them.
+	if (!bvh) bvh = new Bvh(scene);
+
+	int mismatches = bvh->validate(scene, rayCount);
+
+	delete bvh;
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	bool buildBvh = true;
+	std::vector<const char*> arguments;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-bvh") == 0) buildBvh = false;
+		else arguments.push_back(argv[i]);
+	}
+
+	bool defaultScene = arguments.size() == 3 && strcmp(arguments[0], "--default") == 0;
+	bool validation = (arguments.size() == 2 || arguments.size() == 3) && strcmp(arguments[0], "--validate-bvh") == 0;
+
+	if (validation)
+	{
+		return validateSceneFile(arguments[1], arguments.size() == 3 ? atoi(arguments[2]) : 16384);
+	}
+
+	if (arguments.size() != 2 && !defaultScene)
+	{
+		std::cout << "Usage: SceneConverter <scene.json | mesh.obj> <output.rtscene> [--no-bvh]" << std::endl;
+		std::cout << "       SceneConverter --default <extra spheres> <output.rtscene> [--no-bvh]" << std::endl;
+		std::cout << "       SceneConverter --validate-bvh <scene.rtscene> [rays]" << std::endl;
+
+		return -1;
+	}
+
+	Clock::time_point start = Clock::now();
+
+	std::string input(arguments[0]);
+	const char* output = arguments.back();
+
+	Scene scene;
+	bool converted = true;
+
+	if (defaultScene)
+	{
+		scene = createDefaultScene(atoi(arguments[1]));
+	}
+	else if (input.size() >= 5 && input.compare(input.size() - 5, 5, ".json") == 0)
+	{
+		converted = convertJson(input.c_str(), scene);
+	}
+	else
+	{
+		converted = convertObj(input.c_str(), scene);
+	}
+
+	if (!converted) return -1;
+
+	// Primitive references only have room for 30 bits of index, see "bvh.h".
+	size_t largestArray = std::max(scene.spheres.size(), std::max(scene.planes.size(), scene.triangles.size()));
+
+	if (largestArray > PRIMITIVE_INDEX_MASK)
+	{
+		std::cout << "[ERROR] SCENE CONVERTER: Too many primitives of a single type (" << largestArray << ")." << std::endl;
+
+		return -1;
+	}
+
+	Bvh* bvh = buildBvh ? new Bvh(scene) : NULL;
+
+	bool saved = saveSceneFile(output, scene, bvh);
+
+	delete bvh;
+
+	if (!saved) return -1;
+
+	float seconds = std::chrono::duration<float>(Clock::now() - start).count();
+
+	std::cout << "[INFO] SCENE CONVERTER: Wrote \"" << output << "\" (" << scene.spheres.size() << " spheres, " << scene.planes.size()
+		<< " planes, " << scene.triangles.size() << " triangles, " << scene.instances.size() << " instances) in " << seconds << " s." << std::endl;
+
+	return 0;
+}
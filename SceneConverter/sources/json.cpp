@@ -0,0 +1,278 @@
+#include "json.h"
+
+struct JsonParser
+{
+	const char* begin;
+	const char* cursor;
+
+	std::string error;
+
+	void fail(const char* message)
+	{
+		if (!error.empty()) return;
+
+		int line = 1;
+
+		for (const char* c = begin; c < cursor; c++)
+		{
+			if (*c == '\n') line++;
+		}
+
+		error = std::string(message) + " on line " + std::to_string(line) + ".";
+	}
+
+	void skipWhitespace()
+	{
+		while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r') cursor++;
+	}
+
+	bool consume(const char* token)
+	{
+		size_t length = strlen(token);
+
+		if (strncmp(cursor, token, length) != 0) return false;
+
+		cursor += length;
+
+		return true;
+	}
+
+	bool parseString(std::string& string)
+	{
+		cursor++; // Opening quote.
+
+		while (*cursor != '"')
+		{
+			if (*cursor == '\0')
+			{
+				fail("Unterminated string");
+
+				return false;
+			}
+
+			if (*cursor != '\\')
+			{
+				string += *cursor++;
+
+				continue;
+			}
+
+			cursor++;
+
+			switch (*cursor++)
+			{
+			case '"': string += '"'; break;
+			case '\\': string += '\\'; break;
+			case '/': string += '/'; break;
+			case 'b': string += '\b'; break;
+			case 'f': string += '\f'; break;
+			case 'n': string += '\n'; break;
+			case 'r': string += '\r'; break;
+			case 't': string += '\t'; break;
+			case 'u':
+			{
+				char digits[5] = {};
+
+				for (int i = 0; i < 4; i++)
+				{
+					if (!isxdigit((unsigned char)*cursor))
+					{
+						fail("Invalid unicode escape");
+
+						return false;
+					}
+
+					digits[i] = *cursor++;
+				}
+
+				long code = strtol(digits, NULL, 16);
+
+				string += code < 128 ? (char)code : '?';
+
+				break;
+			}
+			default:
+				cursor--;
+				fail("Invalid escape sequence");
+
+				return false;
+			}
+		}
+
+		cursor++; // Closing quote.
+
+		return true;
+	}
+
+	bool parseValue(JsonValue& value, int depth)
+	{
+		skipWhitespace();
+
+		if (depth > 256)
+		{
+			fail("Too deeply nested");
+
+			return false;
+		}
+
+		if (*cursor == '{' || *cursor == '[')
+		{
+			bool object = *cursor == '{';
+			char closing = object ? '}' : ']';
+
+			value.type = object ? JsonValue::OBJECT : JsonValue::ARRAY;
+			cursor++;
+
+			skipWhitespace();
+
+			if (*cursor == closing)
+			{
+				cursor++;
+
+				return true;
+			}
+
+			while (true)
+			{
+				value.elements.push_back(JsonValue());
+
+				JsonValue& element = value.elements.back();
+
+				if (object)
+				{
+					skipWhitespace();
+
+					if (*cursor != '"')
+					{
+						fail("Expected a member name");
+
+						return false;
+					}
+
+					if (!parseString(element.key)) return false;
+
+					skipWhitespace();
+
+					if (!consume(":"))
+					{
+						fail("Expected ':'");
+
+						return false;
+					}
+				}
+
+				if (!parseValue(element, depth + 1)) return false;
+
+				skipWhitespace();
+
+				if (consume(",")) continue;
+
+				if (*cursor == closing)
+				{
+					cursor++;
+
+					return true;
+				}
+
+				fail(object ? "Expected ',' or '}'" : "Expected ',' or ']'");
+
+				return false;
+			}
+		}
+
+		if (*cursor == '"')
+		{
+			value.type = JsonValue::STRING;
+
+			return parseString(value.string);
+		}
+
+		if (consume("true"))
+		{
+			value.type = JsonValue::BOOLEAN;
+			value.boolean = true;
+
+			return true;
+		}
+
+		if (consume("false"))
+		{
+			value.type = JsonValue::BOOLEAN;
+			value.boolean = false;
+
+			return true;
+		}
+
+		if (consume("null"))
+		{
+			value.type = JsonValue::NUL;
+
+			return true;
+		}
+
+		char* end = NULL;
+
+		value.number = strtod(cursor, &end);
+
+		if (end == cursor)
+		{
+			fail("Unexpected character");
+
+			return false;
+		}
+
+		value.type = JsonValue::NUMBER;
+		cursor = end;
+
+		return true;
+	}
+};
+
+JsonValue::JsonValue()
+	: type(NUL), boolean(false), number(0.0)
+{
+}
+
+const JsonValue* JsonValue::get(const char* name) const
+{
+	if (type != OBJECT) return NULL;
+
+	for (const JsonValue& element : elements)
+	{
+		if (element.key == name) return &element;
+	}
+
+	return NULL;
+}
+
+double JsonValue::getNumber(const char* name, double fallback) const
+{
+	const JsonValue* member = get(name);
+
+	return member && member->type == NUMBER ? member->number : fallback;
+}
+
+const char* JsonValue::getString(const char* name, const char* fallback) const
+{
+	const JsonValue* member = get(name);
+
+	return member && member->type == STRING ? member->string.c_str() : fallback;
+}
+
+bool parseJson(const std::string& text, JsonValue& value, std::string& error)
+{
+	JsonParser parser = { text.c_str(), text.c_str(), std::string() };
+
+	value = JsonValue();
+
+	if (parser.parseValue(value, 0))
+	{
+		parser.skipWhitespace();
+
+		if (*parser.cursor != '\0') parser.fail("Unexpected trailing characters");
+	}
+
+	error = parser.error;
+
+	return error.empty();
+}
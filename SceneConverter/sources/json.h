@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+// Minimal JSON document model, enough for scene descriptions. Numbers are doubles, and "\u" escapes outside of ASCII
+// are replaced by '?'.
+//
+struct JsonValue
+{
+	enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+	Type type;
+
+	bool boolean;
+	double number;
+	std::string string;
+
+	std::vector<JsonValue> elements; // Members of an object carry their name in "key".
+	std::string key;
+
+	JsonValue();
+
+	const JsonValue* get(const char* name) const; // NULL when this is not an object or has no such member.
+
+	double getNumber(const char* name, double fallback) const;
+	const char* getString(const char* name, const char* fallback) const;
+};
+
+// Returns false and describes the first error met, along with its line, when "text" is not valid JSON.
+bool parseJson(const std::string& text, JsonValue& value, std::string& error);
@@ -0,0 +1,100 @@
+#include "obj_reader.h"
+
+static const char* skipSpaces(const char* cursor)
+{
+	while (*cursor == ' ' || *cursor == '\t') cursor++;
+
+	return cursor;
+}
+
+static const char* nextLine(const char* cursor)
+{
+	while (*cursor != '\0' && *cursor != '\n') cursor++;
+
+	return *cursor == '\n' ? cursor + 1 : cursor;
+}
+
+bool readObj(const char* filepath, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+	// The whole file is read at once and parsed in place, the stream extraction operators are far too slow for
+	// meshes of millions of triangles.
+	std::ifstream fileStream(filepath, std::ios::binary | std::ios::ate);
+
+	if (!fileStream)
+	{
+		std::cout << "[ERROR] OBJ READER: Failed to open \"" << filepath << "\"." << std::endl;
+
+		return false;
+	}
+
+	std::string text((size_t)fileStream.tellg(), '\0');
+
+	fileStream.seekg(0);
+	fileStream.read(&text[0], text.size());
+
+	positions.clear();
+	indices.clear();
+
+	std::vector<unsigned int> polygon;
+	int line = 1;
+
+	for (const char* cursor = text.c_str(); *cursor != '\0'; cursor = nextLine(cursor), line++)
+	{
+		cursor = skipSpaces(cursor);
+
+		if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			char* end = (char*)cursor + 1;
+			glm::vec3 position;
+
+			for (int i = 0; i < 3; i++)
+			{
+				position[i] = strtof(end, &end);
+			}
+
+			positions.push_back(position);
+		}
+		else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			polygon.clear();
+
+			cursor = skipSpaces(cursor + 1);
+
+			while (*cursor != '\0' && *cursor != '\n' && *cursor != '\r')
+			{
+				char* end = NULL;
+				long index = strtol(cursor, &end, 10);
+
+				if (end == cursor) break;
+
+				// One based, or relative to the vertices read so far when negative.
+				long resolved = index < 0 ? (long)positions.size() + index : index - 1;
+
+				if (index == 0 || resolved < 0 || resolved >= (long)positions.size())
+				{
+					std::cout << "[ERROR] OBJ READER: Invalid vertex index on line " << line << " of \"" << filepath << "\"." << std::endl;
+
+					return false;
+				}
+
+				polygon.push_back((unsigned int)resolved);
+
+				// Texture coordinate and normal indices ("v/vt/vn") are skipped.
+				cursor = end;
+
+				while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\n' && *cursor != '\r') cursor++;
+
+				cursor = skipSpaces(cursor);
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				indices.push_back(polygon[0]);
+				indices.push_back(polygon[i - 1]);
+				indices.push_back(polygon[i]);
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+// Reads the geometry of a Wavefront OBJ file as an indexed triangle mesh. Only vertex positions ("v") and faces
+// ("f") are read; polygons are split into fans, and negative (relative) indices are supported.
+//
+bool readObj(const char* filepath, std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);